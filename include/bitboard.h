@@ -0,0 +1,68 @@
+#ifndef SMINES_BITBOARD_H
+#define SMINES_BITBOARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Minefield;
+
+// a board small enough to keep every per-tile fact in a single 512 bit plane, which covers all the
+// difficulty presets (30x16 is the biggest). flood fill, neighbor counts, victory checks and
+// single point deductions work on whole planes at once with shifts and masks, instead of going
+// tile by tile like struct Minefield does. meant for code that plays lots of small games without
+// showing them (noguess_populate, smines-sim); the game itself still uses struct Minefield.
+//
+// tile (x, y) is bit y * stride + x, with stride = width + 1: the extra column is always clear, so
+// shifting a plane left or right by one can't carry a tile into the next row.
+// the plane operations are plain loops over the words, written so the compiler can vectorize them.
+
+#define BITBOARD_BITS 512
+#define BITBOARD_WORDS (BITBOARD_BITS / 64)
+
+struct BitPlane {
+    uint64_t words[BITBOARD_WORDS];
+};
+
+struct Bitboard {
+    size_t width;
+    size_t height;
+    size_t mines;
+    size_t stride;
+    struct BitPlane valid; // every tile that's on the board
+    struct BitPlane mine;
+    struct BitPlane visible;
+    struct BitPlane flagged;
+    // how many mines are in the 3x3 around every tile (including itself), like tile_surrounding;
+    // bit-sliced, so bit i of the count is in surrounding[i]
+    struct BitPlane surrounding[4];
+    struct BitPlane zero; // tiles that aren't mines and have no mines around them
+    // mines bitboard_solve found, kept apart from the player's flags like struct Solver does
+    struct BitPlane solved_mines;
+};
+
+// false if a board this size doesn't fit in the planes
+bool bitboard_fits(size_t width, size_t height);
+// an empty board, returns false if it doesn't fit
+bool bitboard_init(struct Bitboard *board, size_t width, size_t height, size_t mines);
+// exactly the mines minefield_populate puts down for the same seed and first click
+void bitboard_populate(struct Bitboard *board, uint64_t seed, size_t cur_x, size_t cur_y);
+// take the mines and visible/flagged tiles from a minefield of a size that fits
+void bitboard_load(struct Bitboard *board, struct Minefield *minefield);
+// put everything back into a minefield_init'ed minefield of the same size, keeping its counters correct
+void bitboard_store(struct Bitboard *board, struct Minefield *minefield);
+
+// same as minefield_reveal_tile: false if a mine was clicked, a visible tile reveals its neighbors
+bool bitboard_reveal(struct Bitboard *board, size_t x, size_t y);
+void bitboard_toggle_flag(struct Bitboard *board, size_t x, size_t y);
+bool bitboard_check_victory(struct Bitboard *board);
+uint8_t bitboard_surrounding(struct Bitboard *board, size_t x, size_t y);
+// same as minefield_3bv; `openings` (if not NULL) gets how many openings there are, like
+// minefield.openings.count
+size_t bitboard_3bv(struct Bitboard *board, size_t *openings);
+// reveal every tile the single point deductions (see solver.h) prove safe, over and over until they
+// can't find anything else; returns how many tiles were revealed
+// the subset deductions aren't done here, so this can get stuck where struct Solver wouldn't
+size_t bitboard_solve(struct Bitboard *board);
+
+#endif
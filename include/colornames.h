@@ -24,6 +24,12 @@
 #define MSG_DEATH 16
 #define MSG_WIN   17
 
+#define HEAT_SAFE   18
+#define HEAT_LOW    19
+#define HEAT_MEDIUM 20
+#define HEAT_HIGH   21
+#define HEAT_MINE   22
+
 
 // extra colors that ncurses doesn't define by default
 #define COLOR_LIGHT_BLACK   8
@@ -0,0 +1,22 @@
+#ifndef SMINES_DIFFICULTY_H
+#define SMINES_DIFFICULTY_H
+
+#include <stddef.h>
+
+// the board sizes --difficulty knows about, shared by everything that takes that option
+struct Difficulty {
+    const char *name;
+    const char *alias; // also accepted, NULL if there isn't one
+    size_t width;
+    size_t height;
+    size_t mines;
+};
+
+// from easiest to hardest
+extern const struct Difficulty difficulties[];
+extern const size_t difficulties_len;
+
+// look up a difficulty by name or alias, ignoring case; NULL if there's no such difficulty
+const struct Difficulty *difficulty_find(const char *name);
+
+#endif
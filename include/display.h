@@ -1,45 +1,81 @@
 #ifndef SMINES_DISPLAY_H
 #define SMINES_DISPLAY_H
 
+#include "display_backend.h"
 #include "game.h"
+#include "infinite.h"
 #include "minefield.h"
 
-#include <ncurses.h>
-
 enum DisplayState {
     GAME, // showing the minesweeper game
     HELP, // help menu
 };
 struct Display {
+    struct DisplayBackend backend; // everything is drawn through this
     bool too_small;
     bool erase_needed; // if entire screen needs to be erased (during transition)
+    bool repaint_needed; // if every tile has to be drawn, instead of just the dirty ones
+    enum GameState drawn_state; // game state the minefield was last drawn with
+    bool heatmap; // draw hidden tiles with their chance of being a mine, from game.probability
+    uint64_t drawn_generation; // game.probability.generation the heatmap was last drawn with
     struct Game *game;
     uint32_t game_number;
+    const char *status; // shown on the top line instead of the help hint when set (like the replay position)
     enum DisplayState state; // current screen we are displaying
-    WINDOW *scoreboard;
-    WINDOW *minefield;
-    WINDOW *too_small_popup;
 
+    int rows, cols; // size of the screen, as of the last display_resize
     struct {
         int x, y;
     } origin;
+    // the part of the minefield that fits on the screen, it scrolls to follow the cursor
+    // only this part is ever drawn, so huge boards cost no more to draw than small ones
+    struct {
+        int x, y; // top-left tile
+        int width, height; // in tiles
+    } view;
+
+    // drawn instead of game after display_set_infinite (game is NULL then). the view's size is still in
+    // view, but where it starts is here, since the board goes on both ways
+    struct {
+        struct InfiniteField *field;
+        const enum GameState *state; // the caller's, nothing in the field says when the game's over
+        int64_t x, y; // top-left tile of the view
+    } infinite;
 
     int min_width, min_height;
+
+    // how every possible tile looks (indexed by tile bits without TILE_DIRTY_BIT), rebuilt whenever
+    // the game state changes, so drawing a tile is just a lookup
+    struct Cell tile_cells[TILE_DIRTY_BIT][2];
+    struct Cell heat_cells[2]; // the heatmap depends on more than tile bits, so those are built here as needed
+    // one row of the view is built up here, then drawn in a single put_cells
+    struct Cell *row_cells;
+    size_t row_cells_cap;
 };
 
-// should only be called once; there should only be one Display!
+// should only be called once per backend; the display takes ownership of it
 // needs to be cleaned up with display_destroy
-void display_resize(struct Display *display);
 // returns bool, true if successful. if false, terminate the entire program
 // not ready for use until you call display_set_game
-bool display_init(struct Display *display);
+bool display_init(struct Display *display, struct DisplayBackend backend);
+void display_resize(struct Display *display);
 void display_set_game(struct Display *display, struct Game *game);
+// show an endless board instead of a game, with its cursor and the game state in `state`
+// there's no dirty list, so every display_draw draws the whole view (only a screenful of tiles)
+void display_set_infinite(struct Display *display, struct InfiniteField *field, const enum GameState *state);
+// also destroys the backend
 void display_destroy(struct Display *display);
+// blocks until a key is pressed, returns a char or enum DisplayKey
+int display_get_key(struct Display *display);
+// same, but returns DISPLAY_KEY_NONE if no key came within timeout_ms
+int display_poll_key(struct Display *display, int timeout_ms);
 // remember to refresh manually
+// only tiles in minefield.dirty are drawn again, unless the screen was erased, the game state changed
+// or the view scrolled
 void display_draw(struct Display *display);
-// draw the entire minefield
-// TODO: damage/regional update
 void display_refresh(struct Display *display);
+// the caller has to keep game.probability up to date while this is on (game_update_probabilities)
+void display_toggle_heatmap(struct Display *display);
 // switch to help screen
 void display_transition_help(struct Display *display);
 // switch to main game screen
@@ -0,0 +1,69 @@
+#ifndef SMINES_DISPLAY_BACKEND_H
+#define SMINES_DISPLAY_BACKEND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// what struct Display draws onto: a grid of cells, plus a source of key presses
+//
+// display.c only talks to this interface, so the same game loop can run on a real terminal
+// (ncurses), into memory (buffer, for scripted runs and tests), or into nothing at all (null,
+// to measure the game/display logic without any rendering cost)
+
+enum CellAttr {
+    CELL_BOLD = 1 << 0,
+};
+struct Cell {
+    char ch;
+    uint8_t color; // color pair from colornames.h, 0 for the terminal default
+    uint8_t attr; // enum CellAttr flags
+};
+
+// keys that aren't plain characters; plain characters are returned as-is
+enum DisplayKey {
+    DISPLAY_KEY_EOF = -1, // no more input will ever come (end of a key script)
+    DISPLAY_KEY_NONE = -2, // poll_key ran out of time
+    DISPLAY_KEY_LEFT = 0x100,
+    DISPLAY_KEY_RIGHT,
+    DISPLAY_KEY_UP,
+    DISPLAY_KEY_DOWN,
+    DISPLAY_KEY_RESIZE, // terminal size changed, call display_resize
+};
+
+// coordinates are 0-based (row, column) on the whole screen
+// anything drawn past the edge of the screen is clipped by the backend
+struct DisplayBackendOps {
+    void (*destroy)(void *ctx);
+    void (*get_size)(void *ctx, int *rows, int *cols);
+    void (*erase)(void *ctx); // clear the whole screen
+    void (*clear_rect)(void *ctx, int y, int x, int height, int width);
+    void (*put_cells)(void *ctx, int y, int x, const struct Cell *cells, int n);
+    void (*put_text)(void *ctx, int y, int x, const char *text, uint8_t color, uint8_t attr);
+    void (*draw_box)(void *ctx, int y, int x, int height, int width);
+    void (*refresh)(void *ctx); // make everything drawn so far visible
+    int (*get_key)(void *ctx); // blocks until a key is pressed, returns a char or enum DisplayKey
+    // like get_key, but gives up with DISPLAY_KEY_NONE after timeout_ms
+    // scripted keys never have to be waited for, so a script that ran out only ever times out
+    int (*poll_key)(void *ctx, int timeout_ms);
+};
+struct DisplayBackend {
+    const struct DisplayBackendOps *ops;
+    void *ctx;
+};
+
+// all of these return false if the backend couldn't be set up
+// destroy with backend->ops->destroy(backend->ctx) (display_destroy does that)
+
+// the real terminal
+bool display_backend_ncurses_init(struct DisplayBackend *backend);
+// an in-memory rows*cols grid of cells, keys are read from `keys` (which must outlive the backend)
+bool display_backend_buffer_init(struct DisplayBackend *backend, int rows, int cols, const char *keys);
+// get the cells of a buffer backend, row by row
+const struct Cell *display_backend_buffer_cells(struct DisplayBackend *backend, int *rows, int *cols);
+// write the characters of a buffer backend as plain text, one line per row
+void display_backend_buffer_dump(struct DisplayBackend *backend, FILE *file);
+// draws nothing, pretends to be rows*cols big, keys are read from `keys`
+bool display_backend_null_init(struct DisplayBackend *backend, int rows, int cols, const char *keys);
+
+#endif
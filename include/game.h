@@ -1,7 +1,10 @@
 #ifndef SMINES_GAME_H
 #define SMINES_GAME_H
 
+#include "journal.h"
 #include "minefield.h"
+#include "probability.h"
+#include "solver.h"
 
 #include <stddef.h>
 #include <stdint.h>
@@ -14,17 +17,36 @@ enum GameState {
 struct Game {
     enum GameState state;
     struct Minefield minefield;
-    struct {
-        enum GameState state;
-        // TODO: deep copy tiles array
-        struct Minefield minefield;
-    } undo;
+    // every click and flag is recorded here, so they can be undone and redone
+    struct Journal journal;
+    // follows along with every reveal, for hints and autoplay
+    struct Solver solver;
+    // only worked out when asked for, with game_update_probabilities
+    struct Probability probability;
+    size_t guesses; // moves game_autoplay made without knowing they were safe
 };
 
-void game_init(struct Game *game, size_t width, size_t height, size_t mines);
+// undo_bytes is how much memory the undo history may use; 0 turns undo off, SIZE_MAX for unlimited
+void game_init(struct Game *game, size_t width, size_t height, size_t mines, uint64_t seed, size_t undo_bytes);
+// game_init without allocating or clearing anything the size of the board: the game starts on `board`
+// (set up with minefield_init, maybe populated already) and the solver on `solver_tiles` (width * height,
+// zeroed), which get swapped with the last game's board and solver tiles for the caller to reuse
+void game_init_swap(struct Game *game, struct Minefield *board, uint8_t **solver_tiles, size_t undo_bytes);
 void game_cleanup(struct Game *game);
 void game_click_tile(struct Game *game, size_t x, size_t y);
-void game_undo_store(struct Game *game);
-void game_undo(struct Game *game);
+void game_toggle_flag(struct Game *game, size_t x, size_t y);
+// both return false if there was nothing to undo/redo
+// they take time proportional to how many tiles the move changed, not the size of the board
+bool game_undo(struct Game *game);
+bool game_redo(struct Game *game);
+// the closest tile to the cursor that's certainly safe, false if the solver can't find any
+bool game_hint(struct Game *game, size_t *x, size_t *y);
+// reveal every tile the solver knows is safe and flag every tile it knows is a mine, over and over
+// until it's stuck or the game is over; all of it is a single move for undo
+// if `guess` is set, it doesn't stop when stuck, it reveals the tile least likely to be a mine and keeps going
+// returns how many tiles were revealed or flagged
+size_t game_autoplay(struct Game *game, bool guess);
+// work out game.probability again if anything changed since last time, returns false if out of memory
+bool game_update_probabilities(struct Game *game);
 
 #endif
@@ -0,0 +1,81 @@
+#ifndef SMINES_INFINITE_H
+#define SMINES_INFINITE_H
+
+#include "minefield.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// a board with no edges, made up of square chunks that only exist once something looks at them
+//
+// every chunk's mines come from the seed and the chunk's coordinates alone (the same chunk_mines in
+// every chunk), so chunks can be made in any order and always come out the same. a chunk starts out
+// as just its mine plane; its tiles are only allocated once a tile in it is revealed or asked for
+// with infinite_get_tile. counting a chunk's numbers needs the mine planes of the chunks around it,
+// which are made too, but those stay at 512 bytes each until they're looked at themselves.
+// so memory goes with how much of the board was explored, not with how big it is.
+//
+// the first click is always at (0, 0), and the 3x3 around it never has mines (the chunks it touches
+// have that many fewer mines).
+// tile coordinates go in both directions from there, as int64_t.
+
+#define INFINITE_CHUNK_SIZE 64 // tiles per side, a row of a chunk's mines is one word
+
+struct InfiniteChunk {
+    int64_t x, y; // in chunks, tile (x, y) is in chunk (x / 64, y / 64) rounded down
+    uint64_t mines[INFINITE_CHUNK_SIZE]; // bit x of mines[y] is local tile (x, y)
+    struct Tile *tiles; // INFINITE_CHUNK_SIZE rows of INFINITE_CHUNK_SIZE, NULL until it's needed
+};
+
+struct InfiniteField {
+    uint64_t seed;
+    size_t chunk_mines;
+    // hash table of every chunk made so far, open addressing with linear probing
+    // the chunks themselves never move, so tile pointers stay valid until infinite_cleanup
+    struct {
+        struct InfiniteChunk **items; // NULL for empty slots
+        size_t len;
+        size_t cap; // always a power of 2
+    } chunks;
+    size_t tile_chunks; // chunks that have their tiles allocated
+    struct InfiniteChunk *last; // the chunk the last lookup found, most lookups are in the same one
+
+    // starts on the first click; nothing here moves it, it's only kept for whoever's playing
+    struct {
+        int64_t x, y;
+    } cur;
+
+    size_t visible_tiles;
+    size_t placed_flags;
+    // set (and left set) once a chunk or the reveal stack couldn't be allocated. whatever ran into it
+    // stopped there: infinite_get_tile returned NULL, or a reveal stopped partway, leaving visible zeroes
+    // with hidden neighbors that revealing one of them again picks back up from
+    bool out_of_memory;
+
+    // worklist used by infinite_reveal_tile, tile coordinates as (x, y) pairs
+    struct {
+        int64_t *items;
+        size_t cap; // in pairs
+    } reveal_stack;
+};
+
+// chunk_mines has to be at least INFINITE_MIN_CHUNK_MINES: with fewer mines one opening could go on
+// forever, and infinite_reveal_tile would never return
+#define INFINITE_MIN_CHUNK_MINES (INFINITE_CHUNK_SIZE * INFINITE_CHUNK_SIZE / 8)
+
+// returns false if chunk_mines is out of range, or the chunk table couldn't be allocated
+// remember to run infinite_cleanup afterwards, even if this failed
+bool infinite_init(struct InfiniteField *field, uint64_t seed, size_t chunk_mines);
+void infinite_cleanup(struct InfiniteField *field);
+// allocates the tile's chunk if it doesn't have its tiles yet, NULL if out of memory
+struct Tile *infinite_get_tile(struct InfiniteField *field, int64_t x, int64_t y);
+// same as minefield_reveal_tile: false if the tile was a mine, and a visible tile reveals its neighbors
+// the flood fill goes across chunks, making them as it gets to them
+bool infinite_reveal_tile(struct InfiniteField *field, int64_t x, int64_t y);
+// toggle the flag on a hidden tile, does nothing if the tile is already visible
+void infinite_toggle_flag(struct InfiniteField *field, int64_t x, int64_t y);
+// how much memory the chunks and the chunk table take
+size_t infinite_memory(struct InfiniteField *field);
+
+#endif
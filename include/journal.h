@@ -0,0 +1,65 @@
+#ifndef SMINES_JOURNAL_H
+#define SMINES_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// undo/redo history that only stores the tiles each move changed
+//
+// while a move is being recorded, the minefield calls journal_record with every tile's
+// state right before it changes. undoing a move swaps those states back into the board
+// (and the current ones into the journal), so redoing is the same swap in the other direction.
+
+// a tile's offset (y * width + x) shifted up by 8, or'd with the tile bits
+typedef uint64_t JournalEntry;
+#define JOURNAL_ENTRY(offset, bits) (((JournalEntry)(offset) << 8) | (bits))
+#define JOURNAL_ENTRY_OFFSET(entry) ((size_t)((entry) >> 8))
+#define JOURNAL_ENTRY_BITS(entry) ((uint8_t)((entry) & 0xff))
+
+struct JournalMove {
+    size_t start; // index of this move's first entry
+    // what to go back to; gets swapped with the current values on undo/redo just like the tiles
+    struct {
+        int x;
+        int y;
+    } cur;
+    int state; // whatever state the owner wants restored (struct Game stores its enum GameState here)
+};
+
+struct Journal {
+    JournalEntry *entries;
+    size_t len; // entries in use, by both undoable and redoable moves
+    size_t cap;
+
+    struct JournalMove *moves;
+    size_t moves_len;
+    size_t moves_cap;
+    size_t head; // moves before this can be undone, moves from here on can be redone
+
+    size_t max_bytes; // oldest moves are forgotten past this, 0 means no limit
+    bool recording; // between journal_begin and journal_end
+    // the move being recorded; it only goes into moves (and throws away the redo history) once it
+    // records its first tile, so moves that change nothing leave everything as it was
+    struct JournalMove pending;
+    bool pending_added;
+};
+
+// a zeroed struct Journal is also valid (with no memory limit)
+void journal_init(struct Journal *journal, size_t max_bytes);
+void journal_cleanup(struct Journal *journal);
+// forget everything, but keep the buffers around for the next game
+void journal_clear(struct Journal *journal);
+
+// start recording a move; its first journal_record throws away anything that could have been redone
+// if either of these runs out of memory, the whole history is forgotten (like journal_clear) and the
+// rest of the move isn't recorded, so undo just has nothing left to undo instead of undoing half a move
+void journal_begin(struct Journal *journal, int cur_x, int cur_y, int state);
+void journal_record(struct Journal *journal, size_t offset, uint8_t bits);
+// stop recording; moves that didn't change any tiles are dropped, without touching the redo history
+void journal_end(struct Journal *journal);
+
+// entries [*start, *end) of a move
+void journal_move_entries(struct Journal *journal, size_t move, size_t *start, size_t *end);
+
+#endif
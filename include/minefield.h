@@ -1,46 +1,171 @@
 #ifndef SMINES_MINEFIELD_H
 #define SMINES_MINEFIELD_H
 
+#include "journal.h"
+#include "rng.h"
+
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+struct Solver;
+
+// everything about a tile is packed into a single byte so big boards stay small
+// use the tile_* accessors below instead of poking at the bits directly
 struct Tile {
-    bool mine;
-    bool visible;
-    bool flagged;
-    uint8_t surrounding; // if mine, this value is undefined!
+    uint8_t bits;
+};
+enum TileBits {
+    TILE_SURROUNDING_MASK = 0x0f, // low nibble, if mine, this value is undefined!
+    TILE_MINE_BIT         = 0x10,
+    TILE_VISIBLE_BIT      = 0x20,
+    TILE_FLAGGED_BIT      = 0x40,
+    TILE_DIRTY_BIT        = 0x80, // already in minefield.dirty, don't add it again
 };
 
+static inline bool tile_is_mine(const struct Tile *tile) {
+    return tile->bits & TILE_MINE_BIT;
+}
+static inline bool tile_is_visible(const struct Tile *tile) {
+    return tile->bits & TILE_VISIBLE_BIT;
+}
+static inline bool tile_is_flagged(const struct Tile *tile) {
+    return tile->bits & TILE_FLAGGED_BIT;
+}
+// how many mines are in the 3x3 around the tile (including itself)
+static inline uint8_t tile_surrounding(const struct Tile *tile) {
+    return tile->bits & TILE_SURROUNDING_MASK;
+}
+
 // TODO: size_t or int/uint?
 struct Minefield {
     size_t width;
     size_t height;
     size_t mines;
+    uint64_t seed; // minefield_populate always generates the same board for the same seed and cursor
+    struct Rng rng;
     size_t placed_flags;
+    // running counts kept up to date by every function that changes tiles,
+    // so nothing has to rescan the board to find them
+    size_t visible_tiles;
+    size_t correct_flags; // flags placed on top of a mine
     struct {
         int x;
         int y;
     } cur;
-    struct Tile *tiles;
+    // 0 stores the tiles in plain rows (y * width + x). otherwise they're stored in square blocks of
+    // (1 << block_shift) tiles per side, block after block in row order, so the tiles above and below
+    // are usually in the same cache line or page instead of `width` bytes away (3 and 4 are good choices).
+    // only minefield_get_tile knows where a tile is stored; offsets everywhere else (journal, dirty,
+    // solver, ...) are still y * width + x. kept by minefield_init, so set it before that
+    unsigned block_shift;
+    size_t blocks_wide; // blocks in a row of blocks, only used with block_shift
+    // openings bigger than a few tens of thousands of tiles are finished on this many threads; 0 or 1
+    // keeps every reveal on the calling thread. the tiles revealed are the same either way. kept by
+    // minefield_init
+    int reveal_threads;
+    struct Tile *tiles; // minefield_tiles_len of them, including the padding of partly used blocks
+    // set when the tiles are used in place inside a mapped file (see minefield_adopt_tiles), NULL when
+    // they're their own allocation
+    struct {
+        void *addr;
+        size_t len;
+    } tiles_map;
+
+    // with this set, minefield_populate also works out every opening (zeroes that touch, plus the numbers
+    // around them) with a union-find over the zeroes. revealing a zero in an opening nobody has touched
+    // yet then marks the whole opening at once instead of flood filling it, and the board's 3BV and
+    // number of openings are known without another pass. costs about 8 bytes per tile.
+    // kept by minefield_init, which throws away the last board's index
+    bool index_openings;
+    struct {
+        bool built; // false until minefield_populate, and if the index didn't fit in memory
+        uint32_t *ids; // for every tile (y * width + x), 1 + the opening it's in if it's a zero, else 0
+        size_t *start; // opening k's tiles are tiles[start[k]] up to tiles[start[k + 1]]
+        uint32_t *tiles; // tile offsets; numbers next to several openings are listed in each of them
+        size_t count;
+        size_t bv3; // what minefield_3bv returns
+    } openings;
+
+    // while this is set and recording, every tile's old state is recorded here before it changes
+    struct Journal *journal;
+    // if set, gets told about every tile that's revealed, so it can keep its frontier up to date
+    struct Solver *solver;
+
+    // worklist used by minefield_reveal_tile, grows as reveals need it (never past the board)
+    // holds tile offsets (y * width + x) of revealed zeroes that still need their neighbors checked
+    struct {
+        size_t *items;
+        size_t cap;
+    } reveal_stack;
+
+    // tiles that have to be drawn again since the last minefield_clear_dirty, as offsets (y * width + x)
+    // filled in by everything that changes how a tile looks (including moving the cursor on/off it)
+    struct {
+        size_t *items;
+        size_t len;
+        size_t cap;
+        bool all; // list got too long, or something board-wide changed; just redraw everything
+    } dirty;
 };
 
 // does not populate mines, remember to run minefield_populate!
-// also remember to run minefield_cleanup afterwards; it frees the tiles array
+// also remember to run minefield_cleanup afterwards; it frees the tiles array and reveal_stack
+// calling it again on a board that's already initialized starts a new game, reusing the tiles array if
+// the new board is the same size
 //
 // if this returns false, then the tiles allocation failed! (and errno was likely set by calloc)
-bool minefield_init(struct Minefield *minefield, size_t width, size_t height, size_t mines);
+bool minefield_init(struct Minefield *minefield, size_t width, size_t height, size_t mines, uint64_t seed);
 void minefield_cleanup(struct Minefield *minefield);
 void minefield_populate(struct Minefield *minefield);
+// fill in minefield.openings for a populated board (minefield_populate already does with index_openings),
+// the tiles that were revealed so far don't matter; throws away the index it had already, and leaves it
+// unbuilt if out of memory
+void minefield_index_openings(struct Minefield *minefield);
+// the mines minefield_populate would pick, for code that keeps its own kind of board: calls place for each
+// one, is_placed has to say whether a tile was already passed to place. rng has to be seeded with the seed
+void minefield_sample_mines(size_t width, size_t height, size_t mines, size_t cur_x, size_t cur_y, struct Rng *rng,
+                            bool (*is_placed)(void *ctx, size_t x, size_t y), void (*place)(void *ctx, size_t x, size_t y),
+                            void *ctx);
+// use `tiles` (minefield_tiles_len of them, somewhere inside the mmap'ed `map`) instead of the board's own
+// tiles; the mapping is unmapped by the next minefield_init or minefield_cleanup
+void minefield_adopt_tiles(struct Minefield *minefield, struct Tile *tiles, void *map, size_t map_len);
 struct Tile *minefield_get_tile(struct Minefield *minefield, size_t x, size_t y);
+// how many tiles the tiles array holds, more than width * height if blocks stick out past the edges
+size_t minefield_tiles_len(const struct Minefield *minefield);
 // output: bool - false if the clicked tile was a mine, true otherwise
+// if the tile is already visible, all of its hidden unflagged neighbors get revealed too
+// flood fill is iterative, so huge openings won't blow up the call stack
 bool minefield_reveal_tile(struct Minefield *minefield, size_t x, size_t y);
+// move the cursor, marking both the old and new tile dirty
+void minefield_set_cursor(struct Minefield *minefield, int x, int y);
+// the whole board needs to be drawn again
+void minefield_mark_all_dirty(struct Minefield *minefield);
+// call after drawing everything in minefield.dirty
+void minefield_clear_dirty(struct Minefield *minefield);
+// toggle the flag on a hidden tile, does nothing if the tile is already visible
+void minefield_toggle_flag(struct Minefield *minefield, size_t x, size_t y);
+// put `*bits` into a tile and the tile's old state into `*bits`, keeping the counters correct
+// (the solver has to rescan after this)
+void minefield_swap_tile_state(struct Minefield *minefield, size_t offset, uint8_t *bits);
+// the same, but only the visible and flagged bits are put in: the mine and the number stay whatever the
+// board has now. used to apply undo/redo from a struct Journal, since moves from before the board was
+// populated (flags) recorded a blank tile
+void minefield_swap_tile_marks(struct Minefield *minefield, size_t offset, uint8_t *bits);
+// make every mine visible (used after dying)
+void minefield_reveal_mines(struct Minefield *minefield);
+// make every tile visible (used after winning)
+void minefield_reveal_all(struct Minefield *minefield);
+// the board's 3BV: the fewest clicks that clear it without flagging (one per opening, plus one per
+// number not next to an opening). only depends on where the mines are, so works on any populated board
+// read straight from minefield.openings when that was built, SIZE_MAX if it wasn't and out of memory
+size_t minefield_3bv(struct Minefield *minefield);
 // get how many mines are surrounding a tile
 size_t minefield_count_surrounding_mines(struct Minefield *minefield, size_t x, size_t y);
 // get how many flags are surrounding a tile
 size_t minefield_count_surrounding_flags(struct Minefield *minefield, size_t x, size_t y);
 
-// check if the game has been won yet
+// check if the game has been won yet, doesn't scan the board
 bool minefield_check_victory(struct Minefield *);
 
 #endif
@@ -0,0 +1,29 @@
+#ifndef SMINES_NOGUESS_H
+#define SMINES_NOGUESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct Minefield;
+
+// boards that can be cleared from the first click without ever having to guess
+//
+// candidate boards are made with minefield_populate from seeds derived from minefield.seed
+// (rng_derive_seed, candidate 0 is the plain board) and played out from the cursor by a private
+// solver; the lowest numbered candidate it can clear is used. candidates are checked ahead on a
+// pool of threads, but since the lowest one wins the board only depends on the seed and cursor,
+// not on how many threads there were or which one finished first.
+//
+// "without guessing" means without guessing for this solver (struct Solver), which doesn't know
+// everything a person could work out, so a few fair boards get thrown away too
+
+// most candidates tried before giving up
+#define NOGUESS_MAX_CANDIDATES 16384
+
+// use instead of minefield_populate, with the cursor on the first click
+// threads is how many to check candidates with, 0 for one per CPU
+// returns false if none of the candidates worked (or out of memory); the minefield still gets the
+// plain board from minefield_populate then, so the game can go on
+bool noguess_populate(struct Minefield *minefield, int threads);
+
+#endif
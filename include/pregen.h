@@ -0,0 +1,51 @@
+#ifndef SMINES_PREGEN_H
+#define SMINES_PREGEN_H
+
+#include "game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// the next game's board, made on a thread of its own while the current one is played
+//
+// restarting used to mean a new board allocation (and page faults all over it) with game_init, then
+// minefield_populate on the first click, both taking longer the bigger the board. instead, the worker
+// clears the last game's tiles and places the next game's mines for a first click in the middle (where
+// minefield_init puts the cursor), and pregen_next_game just swaps that board into the game, so a
+// restart takes the same time whatever the size. the board the game had goes back to the worker to
+// be reused for the game after.
+//
+// boards come from the seed and the first click, so they're exactly the ones game_init and
+// minefield_populate would've made: a first click in the middle uses the mines already placed, one
+// anywhere else clears them and populates again (about as long as it would've taken anyway).
+// nothing is shown about the board until then: its openings index (and 3BV) is hidden until the
+// first click.
+
+struct PregenWorker; // in pregen.c; on the heap so a busy worker can finish after pregen_cleanup
+
+struct Pregen {
+    // NULL if the thread couldn't be started, then every game is made with game_init instead
+    struct PregenWorker *worker;
+    size_t width, height, mines;
+    bool no_guess; // populate with noguess_populate
+    // the game's board came from the worker, with the mines placed for a first click in the middle
+    bool populated;
+    bool openings_built; // whether the board came with its openings index, hidden until the first click
+};
+
+// board size and minefield settings (block_shift, reveal_threads, index_openings) are copied from
+// `game`, which has to be initialized. returns false if the worker couldn't be started; the pregen
+// still works, just without making anything ahead
+bool pregen_init(struct Pregen *pregen, struct Game *game, bool no_guess);
+// doesn't wait for a board that's still being made, the worker frees everything once it's done
+void pregen_cleanup(struct Pregen *pregen);
+// start making the board for `seed`, waiting for the last one to be done first
+void pregen_prepare(struct Pregen *pregen, uint64_t seed);
+// game_init for a board of the pregen's size, using the board pregen_prepare made if it was for `seed`
+// (waiting for it if it isn't done yet)
+void pregen_next_game(struct Pregen *pregen, struct Game *game, uint64_t seed, size_t undo_bytes);
+// use instead of minefield_populate (or noguess_populate) on the first click, with the cursor on it
+void pregen_populate(struct Pregen *pregen, struct Game *game);
+
+#endif
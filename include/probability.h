@@ -0,0 +1,57 @@
+#ifndef SMINES_PROBABILITY_H
+#define SMINES_PROBABILITY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Minefield;
+struct Solver;
+struct ProbabilityMemo;
+
+// the chance of every hidden tile being a mine, given the numbers that are showing and how many
+// mines are left on the board
+//
+// the unknown tiles next to numbers (the frontier) are split into components that don't share
+// any numbers, so they can be counted separately: each component's mine layouts are enumerated by
+// backtracking (on several threads when there are several components), and the counts are
+// combined with how many ways the remaining mines fit in the tiles no number touches.
+// components that look exactly like one from an earlier probability_compute (usually all but the
+// ones next to the last move) are reused from a memo instead of being enumerated again.
+//
+// a component too big to enumerate is treated like tiles no number touches, so its probabilities
+// are only an estimate. same for boards with so many components that combining them exactly would
+// take too long; those assume each component is independent of the others.
+
+struct Probability {
+    struct Minefield *minefield;
+    struct Solver *solver; // what it already found is taken as given
+    // chance of being a mine for every tile, row-major `y * width + x`, independent of
+    // block_shift; 0 for visible tiles
+    float *tiles;
+    size_t tiles_len;
+    float outside; // chance for a hidden tile that no number touches
+    bool exact; // false if any of the estimates above were used
+    // bumped by every probability_compute, so a display can tell when to redraw
+    uint64_t generation;
+    uint64_t solver_revision; // solver.revision as of the last probability_compute
+
+    int threads; // most threads used to enumerate components, 1 to never start any
+    struct ProbabilityMemo *memo;
+};
+
+// for the minefield's current board, call this again for every new board; doesn't allocate anything
+// until probability_compute. remember to run probability_cleanup afterwards
+// a zeroed struct Probability can be passed in the first time
+void probability_init(struct Probability *probability, struct Minefield *minefield, struct Solver *solver);
+void probability_cleanup(struct Probability *probability);
+// run the solver, then work out every tile's chance of being a mine
+// returns false if out of memory, probability.tiles is left as it was
+bool probability_compute(struct Probability *probability);
+// true if the board changed since the last probability_compute
+bool probability_stale(struct Probability *probability);
+// the hidden unflagged tile least likely to be a mine (closest to (x, y) out of equally likely ones)
+// uses the last probability_compute; false if there are no such tiles
+bool probability_best_guess(struct Probability *probability, size_t x, size_t y, size_t *guess_x, size_t *guess_y);
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef SMINES_REPLAY_H
+#define SMINES_REPLAY_H
+
+#include "game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// compact record of a session (every game from start to quit) that can be played back and seeked
+//
+// the file is a header (magic, version, board size, mines, the first game's seed and whether boards
+// were no-guess) followed by events, each a tag byte and some varints (LEB128, signed values zigzag
+// encoded). boards come from the seed and the first click, and every move is replayed through the
+// same engine calls smines made, so an event is usually just its tag; cursor moves are the change
+// from the last cursor event. undo, redo and autoplay are the exception, they're written out as the
+// tiles they changed (offset change from the last one, and whether it's now visible/flagged): undo
+// and redo so playing them back doesn't need the undo history, autoplay because what the solver knows
+// also depends on hints and the heatmap, which aren't recorded. tile state is always
+// (visible | flagged << 1), the mines and numbers only ever come from populating.
+//
+// every REPLAY_SNAPSHOT_INTERVAL events the writer also puts down a snapshot: which tiles are visible
+// or flagged, run length encoded, plus the game state and cursor. snapshots aren't events, they're
+// only there to seek from: restoring one is a populate plus a pass over the board, and then at most
+// REPLAY_SNAPSHOT_INTERVAL events get played to get to any event. boards of more than
+// REPLAY_SNAPSHOT_INTERVAL * REPLAY_SNAPSHOT_TILES tiles get one every (tiles / REPLAY_SNAPSHOT_TILES)
+// events instead, so writing them doesn't cost more than that many tiles per event.
+
+#define REPLAY_VERSION 1
+#define REPLAY_SNAPSHOT_INTERVAL 256
+#define REPLAY_SNAPSHOT_TILES 64
+
+enum ReplayEvent {
+    REPLAY_CURSOR = 1, // x change, y change
+    REPLAY_REVEAL, // space on the cursor, the first one of a game populates the board
+    REPLAY_FLAG, // toggle the flag on the cursor
+    REPLAY_AUTOPLAY, // game state, guesses, then the tiles like REPLAY_TILES
+    REPLAY_TILES, // undo/redo: game state, tile count, then (offset change, tile state) for each tile
+    REPLAY_NEW_GAME, // seed of the next game
+    REPLAY_SNAPSHOT, // length of the rest, game number, seed, first click + 1 (0 if none yet),
+                     // game state, cursor, guesses, then (run length << 2 | tile state) runs
+};
+
+struct ReplayHeader {
+    size_t width, height, mines;
+    uint64_t seed; // of the first game
+    bool no_guess;
+};
+
+struct ReplayWriter {
+    FILE *file;
+    struct Game *game; // where snapshots and undone tiles are read from
+    uint32_t game_number;
+    // where the last cursor event put the cursor; undo moves the game's cursor before the cursor event
+    // for it is written, and playback only ever moves it with cursor events
+    size_t cur_x, cur_y;
+    bool populated;
+    size_t first_x, first_y;
+    size_t since_snapshot; // events
+    bool failed; // a write (or the memory for one) failed, replay_writer_close reports it
+    // snapshots are built here first, since their length goes in front
+    struct {
+        uint8_t *items;
+        size_t len;
+        size_t cap;
+    } scratch;
+};
+
+// returns false if the file couldn't be opened; `game` has to stay the same struct the whole session
+// (it gets game_init'ed again for every new game, that's fine)
+bool replay_writer_open(struct ReplayWriter *writer, const char *path, const struct ReplayHeader *header,
+                        struct Game *game);
+// returns false if anything couldn't be written
+bool replay_writer_close(struct ReplayWriter *writer);
+// call these right after the move was made on the game
+// does nothing if the cursor didn't move since the last event
+void replay_write_cursor(struct ReplayWriter *writer, size_t x, size_t y);
+// REPLAY_REVEAL or REPLAY_FLAG
+void replay_write_action(struct ReplayWriter *writer, enum ReplayEvent event);
+// the tiles come from the minefield's dirty list, so this has to be before the display clears it
+void replay_write_autoplay(struct ReplayWriter *writer);
+// after a successful game_undo/game_redo: the tiles of the move that was just undone/redone
+void replay_write_tiles(struct ReplayWriter *writer, size_t move);
+// after game_init for the next game
+void replay_write_new_game(struct ReplayWriter *writer, uint64_t seed);
+
+// where a snapshot is in the file, and how many events come before it
+struct ReplaySeekPoint {
+    uint64_t event;
+    size_t offset;
+};
+
+struct ReplayPlayer {
+    // the whole file, mmap'ed
+    const uint8_t *data;
+    size_t len;
+    size_t events_offset; // where the first event is
+
+    struct ReplayHeader header;
+    uint64_t events; // in the whole file
+
+    struct {
+        struct ReplaySeekPoint *items;
+        size_t len;
+    } snapshots;
+
+    // the game as of the next event to play
+    struct Game game;
+    uint32_t game_number;
+    bool populated;
+    size_t offset; // of the next event
+    uint64_t event; // events played so far
+};
+
+// maps the file and checks every event once, so playing and seeking can't run into a broken file later
+// returns false if the file couldn't be read or isn't a valid replay
+// remember to run replay_player_close afterwards, even if this failed
+// game.minefield settings (like index_openings) can be set after this, they're kept for every game
+bool replay_player_open(struct ReplayPlayer *player, const char *path);
+void replay_player_close(struct ReplayPlayer *player);
+// play the next event, false if there are none left
+bool replay_player_step(struct ReplayPlayer *player);
+// go to right after `event` events (clamped to the end), from the closest snapshot before it
+void replay_player_seek(struct ReplayPlayer *player, uint64_t event);
+
+#endif
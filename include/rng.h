@@ -0,0 +1,21 @@
+#ifndef SMINES_RNG_H
+#define SMINES_RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** by David Blackman and Sebastiano Vigna (https://prng.di.unimi.it/)
+// small, fast, and the same sequence on every platform, unlike libc rand()
+struct Rng {
+    uint64_t s[4];
+};
+
+// any seed is fine (including 0), it gets expanded with splitmix64
+void rng_seed(struct Rng *rng, uint64_t seed);
+uint64_t rng_next(struct Rng *rng);
+// uniformly distributed number in [0, n), n must not be 0
+uint64_t rng_below(struct Rng *rng, uint64_t n);
+// a seed for the `index`th of many independent streams made from one seed, index 0 is the seed itself
+// (seeding with seed + index would make neighboring streams overlap, splitmix64 just counts up)
+uint64_t rng_derive_seed(uint64_t seed, uint64_t index);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef SMINES_SAVE_H
+#define SMINES_SAVE_H
+
+#include "game.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// a game saved to disk, to be picked up again later
+//
+// the file is a header (struct SaveHeader, padded to SAVE_TILES_OFFSET), then the minefield's tiles
+// exactly like they're stored in memory (blocks and all, see minefield.block_shift), then the undo
+// history and what the solver found (which autoplay goes on from). loading maps the file and the
+// board uses the tiles right where they are in the mapping (privately, so playing doesn't change the
+// file), so resuming a huge board doesn't read it in first: pages only get loaded as they're looked at.
+//
+// the header, the undo history and the solver's tiles are always checked against their checksums.
+// the tiles are only checked for boards up to SAVE_CHECK_MAX_TILES, past that checking would mean
+// reading the whole board, which is the thing this is trying not to do. those boards don't get their
+// openings indexed again either (see minefield.index_openings), so they go without a 3BV.
+// numbers are stored in the machine's own byte order; the magic doesn't match on a machine with the
+// other one, so those files are turned down instead of read wrong.
+
+#define SAVE_MAGIC 0x56534d53 // "SMSV" in little endian
+#define SAVE_VERSION 1
+#define SAVE_TILES_OFFSET 4096 // so the tiles start on their own page
+#define SAVE_CHECK_MAX_TILES ((size_t)1 << 28)
+
+struct SaveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t width, height, mines, seed;
+    uint64_t block_shift;
+    uint64_t placed_flags, visible_tiles, correct_flags;
+    uint64_t cur_x, cur_y;
+    uint64_t state; // enum GameState
+    uint64_t guesses;
+    uint64_t tiles_len; // minefield_tiles_len, the tiles start at SAVE_TILES_OFFSET
+    uint64_t tiles_checksum;
+    // right after the tiles: the entries, then (start, cursor x, cursor y, state) for every move
+    uint64_t journal_entries, journal_moves, journal_head;
+    uint64_t journal_checksum;
+    // after that, every tile the solver knows is safe or a mine, as (offset << 2 | SOLVER_SAFE/SOLVER_MINE)
+    uint64_t solver_tiles;
+    uint64_t solver_checksum;
+    uint64_t header_checksum; // of everything above
+};
+
+// write the game to `path`; it's written to a temporary file next to it first and renamed over it, so
+// a save that fails halfway leaves the last one alone (and a game loaded from `path` can be saved
+// back to it). returns false if anything couldn't be written
+bool save_write(struct Game *game, const char *path);
+// replace `game` (initialized or zeroed) with the one saved in `path`, with undo_bytes like game_init;
+// minefield settings like reveal_threads and index_openings are kept, except block_shift, which has
+// to be the file's. returns false, leaving the game alone, if the file couldn't be read or isn't a
+// valid save
+bool save_load(struct Game *game, const char *path, size_t undo_bytes);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef SMINES_SMINES_H
+#define SMINES_SMINES_H
+
+// public header for libsmines, the game engine without any terminal/ncurses code
+//
+// board creation:  game_init (or minefield_init for just a board), then game_cleanup/minefield_cleanup
+// population:      minefield_populate, once the first click is known (mines avoid the 3x3 around minefield.cur)
+//                  or noguess_populate for a board that never needs a guess (uses threads)
+// reveal:          game_click_tile (updates game.state), or minefield_reveal_tile for just the board
+// flag:            minefield_toggle_flag
+// cursor:          minefield_set_cursor
+// undo:            game_undo/game_redo, for moves made through game_click_tile/game_toggle_flag
+// 3BV:             minefield_3bv
+// solver:          game_hint/game_autoplay, or solver_solve on game.solver for everything it found
+// probabilities:   game_update_probabilities, then game.probability.tiles (uses threads)
+// presets:         difficulty_find, or the difficulties array
+// small boards:    struct Bitboard (bitboard_fits) for playing lots of preset sized games quickly
+// endless boards:  struct InfiniteField, made a chunk at a time as it gets explored
+// replays:         struct ReplayWriter to record a session, struct ReplayPlayer to play one back and seek
+// saving:          save_write/save_load, the board is used straight out of the mapped file
+// restarting:      struct Pregen makes the next game's board on a thread while the current one is played
+// state queries:   game.state, minefield_check_victory, the tile_* accessors on minefield_get_tile,
+//                  and the counters in struct Minefield (placed_flags, visible_tiles, ...)
+//
+// everything is plain data owned by the caller, there is no global state, so separate
+// games can live side by side (as long as each one is only used from one thread at a time;
+// probability_compute starts threads of its own, but they're done before it returns; a Pregen's
+// thread only ever touches boards it was handed)
+
+#include "bitboard.h"
+#include "difficulty.h"
+#include "game.h"
+#include "infinite.h"
+#include "journal.h"
+#include "minefield.h"
+#include "noguess.h"
+#include "pregen.h"
+#include "probability.h"
+#include "replay.h"
+#include "rng.h"
+#include "save.h"
+#include "solver.h"
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef SMINES_SOLVER_H
+#define SMINES_SOLVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct Minefield;
+
+// figures out which hidden tiles are certainly safe and which are certainly mines, using only
+// the numbers that are showing (flags are ignored, the player might have put them in the wrong place)
+//
+// the frontier (visible numbers that still have unknown neighbors) is kept up to date as the game
+// goes: the minefield tells the solver about every tile it reveals (through minefield.solver), and
+// solver_solve only looks at the numbers around those. so solving after a move costs about as much
+// as the move itself, not the whole board.
+//
+// deductions:
+// - single point: a number with no mines left to find makes all its unknown neighbors safe, and
+//   a number with as many mines left as unknown neighbors makes all of them mines
+// - subset: if every unknown neighbor of A is also a neighbor of B, then B's other unknown neighbors
+//   hold exactly (mines left around B) - (mines left around A) mines, which can make them all safe/mines
+
+enum SolverTileBits {
+    SOLVER_SAFE          = 0x01, // certainly not a mine
+    SOLVER_MINE          = 0x02, // certainly a mine
+    SOLVER_QUEUED        = 0x04, // in queue, waiting for single point deductions
+    SOLVER_SUBSET_QUEUED = 0x08, // in subset_queue, waiting for subset deductions
+};
+
+// list of tile offsets (y * width + x)
+struct SolverList {
+    size_t *items;
+    size_t len;
+    size_t cap;
+};
+
+struct Solver {
+    struct Minefield *minefield;
+    // enum SolverTileBits for every tile, row-major `y * width + x`, independent of block_shift
+    uint8_t *tiles;
+    size_t tiles_len; // how many tiles `tiles` has room for
+
+    // tiles revealed since the last solver_solve
+    struct SolverList revealed;
+    // visible numbers whose unknown neighbors changed, and still need to be looked at
+    struct SolverList queue;
+    struct SolverList subset_queue;
+
+    // every tile found so far; tiles in `safe` may have been revealed since
+    struct SolverList safe;
+    struct SolverList mines;
+
+    // tiles changed in a way that isn't tracked (too many at once, mines moved, or undo hid a tile found
+    // safe), or a list couldn't grow, so the next solver_solve has to start over from the whole board
+    bool stale;
+    // bumped whenever the solver hears about a change, so anything built on top of it can tell
+    // when its own results are out of date
+    uint64_t revision;
+};
+
+// the solver is for the minefield's current board, call this again for every new board (a board the same
+// size as the last one reuses its tiles)
+// remember to run solver_cleanup afterwards
+//
+// if this returns false, the allocation failed (and errno was likely set by calloc)
+bool solver_init(struct Solver *solver, struct Minefield *minefield);
+// solver_init, with `tiles` (width * height of them, all zero) used instead of a new allocation; returns
+// the tiles array the solver had before (NULL if none), which now belongs to the caller
+uint8_t *solver_init_with_tiles(struct Solver *solver, struct Minefield *minefield, uint8_t *tiles);
+void solver_cleanup(struct Solver *solver);
+// called by the minefield for every tile it reveals
+void solver_tile_revealed(struct Solver *solver, size_t offset);
+// look at the whole board again on the next solver_solve; what was already found stays found
+void solver_reset(struct Solver *solver);
+// find everything the deductions above can, returns how many new safe tiles and mines were found
+size_t solver_solve(struct Solver *solver);
+// a hidden tile that's certainly safe, as close to (x, y) as possible; false if there aren't any
+// only knows about what was found by the last solver_solve
+bool solver_next_safe(struct Solver *solver, size_t x, size_t y, size_t *safe_x, size_t *safe_y);
+
+#endif
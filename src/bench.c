@@ -0,0 +1,425 @@
+// smines-bench: headless benchmarks for the game engine and the draw path
+//
+// prints one CSV row per (operation, board) pair to stdout, so the output can be diffed or
+// plotted between builds. every board uses a fixed seed, so runs are comparable.
+// drawing is measured on the buffer backend (display logic + building the cells) and on the
+// null backend (display logic only), so terminal I/O never ends up in the numbers.
+// for meaningful numbers, build with `--buildtype=release -Db_ndebug=true`, otherwise the
+// debug consistency checks in minefield_check_victory recount the whole board on every call.
+#define _POSIX_C_SOURCE 200809L
+
+#include "bitboard.h"
+#include "display.h"
+#include "display_backend.h"
+#include "game.h"
+#include "infinite.h"
+#include "minefield.h"
+#include "solver.h"
+
+#include <sys/resource.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// keep repeating an operation until at least this much time was spent on it
+static const double MIN_SECONDS = 0.2;
+static const uint64_t SEED = 0x736d696e6573; // "smines"
+
+struct BenchCase {
+    size_t width, height;
+    double density; // mines / tiles
+};
+static const struct BenchCase cases[] = {
+    { 9,    9,    0.1235 }, // easy
+    { 16,   16,   0.1563 }, // intermediate
+    { 30,   16,   0.2063 }, // hard
+    { 100,  100,  0.05   },
+    { 100,  100,  0.2063 },
+    { 1000, 1000, 0.01   },
+    { 1000, 1000, 0.2063 },
+    { 1000, 1000, 0.9    },
+    { 4000, 4000, 0.001  },
+    { 4000, 4000, 0.2063 },
+};
+// bigger boards than fit on this screen only have the part around the cursor drawn
+static const int MAX_SCREEN_ROWS = 300;
+static const int MAX_SCREEN_COLS = 1000;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void report(const char *op, const char *backend, const struct Game *game, uint64_t iterations, double seconds, double tiles) {
+    const struct Minefield *minefield = &game->minefield;
+    printf("%s,%s,%zu,%zu,%zu,%" PRIu64 ",%" PRIu64 ",%.1f,%.0f,%ld\n",
+            op, backend, minefield->width, minefield->height, minefield->mines, minefield->seed,
+            iterations, seconds / iterations * 1e9, tiles / seconds, peak_rss_kb());
+    fflush(stdout);
+}
+
+static size_t mines_for(const struct BenchCase *bench_case) {
+    size_t mines = bench_case->width * bench_case->height * bench_case->density;
+    size_t max = bench_case->width * bench_case->height - 9;
+    return mines > max ? max : mines;
+}
+
+static void bench_populate(struct Game *game, const struct BenchCase *bench_case, const char *layout) {
+    uint64_t iterations = 0;
+    double spent = 0;
+    while (spent < MIN_SECONDS) {
+        game_init(game, bench_case->width, bench_case->height, mines_for(bench_case), SEED, 0);
+        double start = now();
+        minefield_populate(&game->minefield);
+        spent += now() - start;
+        iterations++;
+    }
+    report("populate", layout, game, iterations, spent, (double)iterations * bench_case->width * bench_case->height);
+}
+
+// first click in the middle of a freshly populated board; `template` is restored before every click
+static void bench_reveal(struct Game *game, const struct Tile *template, const char *layout) {
+    struct Minefield *minefield = &game->minefield;
+    size_t tiles = minefield_tiles_len(minefield);
+    uint64_t iterations = 0;
+    double spent = 0;
+    double revealed = 0;
+    while (spent < MIN_SECONDS) {
+        memcpy(minefield->tiles, template, tiles * sizeof(struct Tile));
+        minefield->visible_tiles = 0;
+        minefield_clear_dirty(minefield);
+        double start = now();
+        minefield_reveal_tile(minefield, minefield->cur.x, minefield->cur.y);
+        spent += now() - start;
+        revealed += minefield->visible_tiles;
+        iterations++;
+    }
+    report("reveal", layout, game, iterations, spent, revealed);
+}
+
+// bench_reveal on a copy of the board bench_populate left behind, false if out of memory
+static bool bench_reveal_populated(struct Game *game, const char *layout) {
+    size_t tiles = minefield_tiles_len(&game->minefield);
+    struct Tile *template = malloc(tiles * sizeof(struct Tile));
+    if (!template) {
+        fprintf(stderr, "out of memory\n");
+        return false;
+    }
+    memcpy(template, game->minefield.tiles, tiles * sizeof(struct Tile));
+    bench_reveal(game, template, layout);
+    free(template);
+    return true;
+}
+
+// everything the solver can find from scratch on the board bench_reveal left behind
+static void bench_solve(struct Game *game) {
+    uint64_t iterations = 0;
+    double spent = 0;
+    while (spent < MIN_SECONDS) {
+        // forget what the last round found, so every round has to find it all again
+        solver_init(&game->solver, &game->minefield);
+        solver_reset(&game->solver);
+        double start = now();
+        solver_solve(&game->solver);
+        spent += now() - start;
+        iterations++;
+    }
+    report("solve", "", game, iterations, spent, (double)iterations * game->minefield.width * game->minefield.height);
+}
+
+static void bench_check_victory(struct Game *game) {
+    uint64_t iterations = 0;
+    double start = now();
+    double spent = 0;
+    volatile bool won = false;
+    // batches keep the clock out of the measurement; they start small in case this is a debug build,
+    // where every call recounts the whole board
+    uint64_t batch = 1;
+    while (spent < MIN_SECONDS) {
+        for (uint64_t i = 0; i < batch; i++) {
+            won |= minefield_check_victory(&game->minefield);
+        }
+        iterations += batch;
+        if (batch < 1000) {
+            batch *= 2;
+        }
+        spent = now() - start;
+    }
+    report("check_victory", "", game, iterations, spent, (double)iterations * game->minefield.width * game->minefield.height);
+}
+
+// the same populate/reveal/solve/check_victory on a struct Bitboard, for boards small enough
+static void bench_bitboard(struct Game *game) {
+    struct Minefield *minefield = &game->minefield;
+    double tiles = minefield->width * minefield->height;
+    struct Bitboard board;
+    uint64_t iterations = 0;
+    double spent = 0;
+    while (spent < MIN_SECONDS) {
+        double start = now();
+        bitboard_init(&board, minefield->width, minefield->height, minefield->mines);
+        bitboard_populate(&board, minefield->seed, minefield->cur.x, minefield->cur.y);
+        spent += now() - start;
+        iterations++;
+    }
+    report("bitboard_populate", "", game, iterations, spent, iterations * tiles);
+
+    struct Bitboard populated = board;
+    iterations = 0;
+    spent = 0;
+    double revealed = 0;
+    while (spent < MIN_SECONDS) {
+        board = populated;
+        double start = now();
+        bitboard_reveal(&board, minefield->cur.x, minefield->cur.y);
+        spent += now() - start;
+        for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+            revealed += __builtin_popcountll(board.visible.words[i]);
+        }
+        iterations++;
+    }
+    report("bitboard_reveal", "", game, iterations, spent, revealed);
+
+    // single point deductions only, so it may stop earlier than bench_solve's solver
+    struct Bitboard opened = board;
+    iterations = 0;
+    spent = 0;
+    while (spent < MIN_SECONDS) {
+        board = opened;
+        double start = now();
+        bitboard_solve(&board);
+        spent += now() - start;
+        iterations++;
+    }
+    report("bitboard_solve", "", game, iterations, spent, iterations * tiles);
+
+    iterations = 0;
+    double start = now();
+    spent = 0;
+    volatile bool won = false;
+    while (spent < MIN_SECONDS) {
+        for (int i = 0; i < 1000; i++) {
+            won |= bitboard_check_victory(&board);
+        }
+        iterations += 1000;
+        spent = now() - start;
+    }
+    report("bitboard_check_victory", "", game, iterations, spent, iterations * tiles);
+}
+
+// populate and reveal on wide boards with each tile layout (see minefield.block_shift), which one
+// is in the backend column
+static const struct BenchCase layout_cases[] = {
+    { 10000, 2000, 0.01   },
+    { 10000, 2000, 0.05   },
+    { 10000, 2000, 0.2063 },
+};
+static const struct {
+    const char *name;
+    unsigned block_shift;
+} layouts[] = {
+    { "rows",     0 },
+    { "blocks8",  3 },
+    { "blocks16", 4 },
+};
+static bool bench_layouts(void) {
+    for (size_t i = 0; i < sizeof(layout_cases) / sizeof(layout_cases[0]); i++) {
+        for (size_t j = 0; j < sizeof(layouts) / sizeof(layouts[0]); j++) {
+            struct Game game = {0};
+            game.minefield.block_shift = layouts[j].block_shift;
+            bench_populate(&game, &layout_cases[i], layouts[j].name);
+            bool ok = bench_reveal_populated(&game, layouts[j].name);
+            game_cleanup(&game);
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// reveal on a board with one huge opening, with minefield.reveal_threads going up; the backend column
+// has the thread count. on a machine with fewer cores than threads this only measures the overhead
+static const struct BenchCase threads_case = { 4000, 4000, 0.01 };
+static const int reveal_threads[] = { 1, 2, 4, 8, 16 };
+static bool bench_reveal_threads(void) {
+    for (size_t i = 0; i < sizeof(reveal_threads) / sizeof(reveal_threads[0]); i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "threads%d", reveal_threads[i]);
+        struct Game game = {0};
+        game.minefield.reveal_threads = reveal_threads[i];
+        bench_populate(&game, &threads_case, name);
+        bool ok = bench_reveal_populated(&game, name);
+        game_cleanup(&game);
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// populate and first click with and without minefield.index_openings (backend "flood" or "indexed"),
+// the index is built by populate, so its cost is in the populate row
+static const struct BenchCase openings_cases[] = {
+    { 1000, 1000, 0.01   },
+    { 4000, 4000, 0.01   },
+    { 1000, 1000, 0.2063 },
+};
+static bool bench_openings(void) {
+    for (size_t i = 0; i < sizeof(openings_cases) / sizeof(openings_cases[0]); i++) {
+        for (int indexed = 0; indexed <= 1; indexed++) {
+            const char *name = indexed ? "indexed" : "flood";
+            struct Game game = {0};
+            game.minefield.index_openings = indexed;
+            bench_populate(&game, &openings_cases[i], name);
+            bool ok = bench_reveal_populated(&game, name);
+            game_cleanup(&game);
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// an endless board explored along a line: the first click at (0, 0), then a click on every safe tile
+// INFINITE_STEP apart out to INFINITE_REACH. memory should only grow with the strip that got explored,
+// the row's width is how many chunks got their tiles, and mines is per chunk
+static const int64_t INFINITE_REACH = 100000;
+static const int64_t INFINITE_STEP = 7;
+static const double infinite_densities[] = { 0.125, 0.2063 };
+static void bench_infinite(double density) {
+    struct InfiniteField field;
+    size_t chunk_mines = INFINITE_CHUNK_SIZE * INFINITE_CHUNK_SIZE * density;
+    if (!infinite_init(&field, SEED, chunk_mines)) {
+        fprintf(stderr, "out of memory\n");
+        infinite_cleanup(&field);
+        return;
+    }
+    // chunks are independent of each other; if the seeds didn't mix both coordinates, (0, 1) and (1, 0)
+    // would come out the same
+    bool same = true;
+    for (int64_t y = 0; y < INFINITE_CHUNK_SIZE && same; y++) {
+        for (int64_t x = 0; x < INFINITE_CHUNK_SIZE && same; x++) {
+            struct Tile *below = infinite_get_tile(&field, x, INFINITE_CHUNK_SIZE + y);
+            struct Tile *right = infinite_get_tile(&field, INFINITE_CHUNK_SIZE + x, y);
+            same = below && right && tile_is_mine(below) == tile_is_mine(right);
+        }
+    }
+    if (same) {
+        fprintf(stderr, "infinite chunks (0, 1) and (1, 0) have the same mines\n");
+        infinite_cleanup(&field);
+        exit(1);
+    }
+    infinite_cleanup(&field);
+    if (!infinite_init(&field, SEED, chunk_mines)) {
+        fprintf(stderr, "out of memory\n");
+        infinite_cleanup(&field);
+        return;
+    }
+
+    uint64_t clicks = 0;
+    double start = now();
+    infinite_reveal_tile(&field, 0, 0);
+    for (int64_t x = INFINITE_STEP; x <= INFINITE_REACH && !field.out_of_memory; x += INFINITE_STEP) {
+        struct Tile *tile = infinite_get_tile(&field, x, 0);
+        if (tile && !tile_is_mine(tile)) {
+            infinite_reveal_tile(&field, x, 0);
+            clicks++;
+        }
+    }
+    double spent = now() - start;
+    if (field.out_of_memory) {
+        fprintf(stderr, "out of memory\n");
+    }
+    printf("infinite_reveal,,%zu,%d,%zu,%" PRIu64 ",%" PRIu64 ",%.1f,%.0f,%ld\n",
+            field.tile_chunks, INFINITE_CHUNK_SIZE, chunk_mines, SEED,
+            clicks, spent / clicks * 1e9, field.visible_tiles / spent, peak_rss_kb());
+    infinite_cleanup(&field);
+}
+
+// full repaint of the view, and a single cursor step (which should only redraw two tiles)
+static void bench_draw(struct DisplayBackend backend, const char *backend_name, struct Game *game) {
+    struct Minefield *minefield = &game->minefield;
+    struct Display display;
+    display_init(&display, backend);
+    display_set_game(&display, game);
+
+    uint64_t iterations = 0;
+    double start = now();
+    double spent = 0;
+    while (spent < MIN_SECONDS) {
+        minefield_mark_all_dirty(minefield);
+        display_draw(&display);
+        display_refresh(&display);
+        iterations++;
+        spent = now() - start;
+    }
+    report("draw_full", backend_name, game, iterations, spent, (double)iterations * display.view.width * display.view.height);
+
+    // step back and forth between two tiles, so the view never has to scroll
+    int home = minefield->cur.x;
+    int step = home > 0 ? home - 1 : home + 1;
+    iterations = 0;
+    start = now();
+    spent = 0;
+    while (spent < MIN_SECONDS) {
+        minefield_set_cursor(minefield, minefield->cur.x == home ? step : home, minefield->cur.y);
+        display_draw(&display);
+        display_refresh(&display);
+        iterations++;
+        spent = now() - start;
+    }
+    report("draw_cursor", backend_name, game, iterations, spent, (double)iterations * 2);
+    display_destroy(&display);
+}
+
+int main(void) {
+    printf("op,backend,width,height,mines,seed,iterations,ns_per_op,tiles_per_sec,peak_rss_kb\n");
+    // first, while peak_rss_kb is still only what these took
+    for (size_t i = 0; i < sizeof(infinite_densities) / sizeof(infinite_densities[0]); i++) {
+        bench_infinite(infinite_densities[i]);
+    }
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const struct BenchCase *bench_case = &cases[i];
+        struct Game game = {0};
+
+        bench_populate(&game, bench_case, "");
+        if (!bench_reveal_populated(&game, "")) {
+            return 1;
+        }
+        bench_solve(&game);
+
+        bench_check_victory(&game);
+        if (bitboard_fits(bench_case->width, bench_case->height)) {
+            bench_bitboard(&game);
+        }
+        // the screen is sized to fit the board if it can, like a terminal would be
+        int rows = bench_case->height + 8 < MAX_SCREEN_ROWS ? bench_case->height + 8 : MAX_SCREEN_ROWS;
+        int cols = bench_case->width * 2 + 32 < MAX_SCREEN_COLS ? bench_case->width * 2 + 32 : MAX_SCREEN_COLS;
+        struct DisplayBackend backend;
+        if (display_backend_buffer_init(&backend, rows, cols, NULL)) {
+            bench_draw(backend, "buffer", &game);
+        }
+        if (display_backend_null_init(&backend, rows, cols, NULL)) {
+            bench_draw(backend, "null", &game);
+        }
+
+        game_cleanup(&game);
+    }
+    if (!bench_layouts() || !bench_reveal_threads() || !bench_openings()) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,334 @@
+#include "bitboard.h"
+
+#include "minefield.h"
+#include "rng.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static inline struct BitPlane bitplane_and(struct BitPlane a, struct BitPlane b) {
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        a.words[i] &= b.words[i];
+    }
+    return a;
+}
+static inline struct BitPlane bitplane_or(struct BitPlane a, struct BitPlane b) {
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        a.words[i] |= b.words[i];
+    }
+    return a;
+}
+static inline struct BitPlane bitplane_andnot(struct BitPlane a, struct BitPlane b) {
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        a.words[i] &= ~b.words[i];
+    }
+    return a;
+}
+static inline bool bitplane_any(struct BitPlane a) {
+    uint64_t any = 0;
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        any |= a.words[i];
+    }
+    return any != 0;
+}
+static inline size_t bitplane_count(struct BitPlane a) {
+    size_t count = 0;
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        count += __builtin_popcountll(a.words[i]);
+    }
+    return count;
+}
+static inline bool bitplane_get(const struct BitPlane *a, size_t bit) {
+    return (a->words[bit / 64] >> (bit % 64)) & 1;
+}
+static inline void bitplane_set(struct BitPlane *a, size_t bit) {
+    a->words[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+static inline void bitplane_flip(struct BitPlane *a, size_t bit) {
+    a->words[bit / 64] ^= (uint64_t)1 << (bit % 64);
+}
+static inline struct BitPlane bitplane_bit(size_t bit) {
+    struct BitPlane a = {{0}};
+    bitplane_set(&a, bit);
+    return a;
+}
+
+// bit i of the result is bit i - n of a
+// (x >> 1) >> (63 - s) is x >> (64 - s) without the undefined shift by 64 when s is 0
+static inline struct BitPlane bitplane_shift_up(struct BitPlane a, size_t n) {
+    struct BitPlane r = {{0}};
+    size_t q = n / 64, s = n % 64;
+    if (q >= BITBOARD_WORDS) {
+        return r;
+    }
+    r.words[q] = a.words[0] << s;
+    for (size_t i = q + 1; i < BITBOARD_WORDS; i++) {
+        r.words[i] = (a.words[i - q] << s) | ((a.words[i - q - 1] >> 1) >> (63 - s));
+    }
+    return r;
+}
+// bit i of the result is bit i + n of a
+static inline struct BitPlane bitplane_shift_down(struct BitPlane a, size_t n) {
+    struct BitPlane r = {{0}};
+    size_t q = n / 64, s = n % 64;
+    if (q >= BITBOARD_WORDS) {
+        return r;
+    }
+    for (size_t i = 0; i + q + 1 < BITBOARD_WORDS; i++) {
+        r.words[i] = (a.words[i + q] >> s) | ((a.words[i + q + 1] << 1) << (63 - s));
+    }
+    r.words[BITBOARD_WORDS - 1 - q] = a.words[BITBOARD_WORDS - 1] >> s;
+    return r;
+}
+
+// every tile in or next to a tile of `a`
+static inline struct BitPlane bitboard_dilate(struct Bitboard *board, struct BitPlane a) {
+    a = bitplane_or(a, bitplane_or(bitplane_shift_up(a, 1), bitplane_shift_down(a, 1)));
+    a = bitplane_or(a, bitplane_or(bitplane_shift_up(a, board->stride), bitplane_shift_down(a, board->stride)));
+    return bitplane_and(a, board->valid);
+}
+
+// how many tiles of `a` are in the 3x3 around every tile (including itself), bit-sliced
+// `a` has to be inside board.valid, so the clear column keeps rows from leaking into each other
+static void bitboard_count_around(struct Bitboard *board, struct BitPlane a, struct BitPlane count[4]) {
+    // each tile and its left and right neighbors first: a 2 bit sum from a full adder
+    struct BitPlane left = bitplane_shift_up(a, 1);
+    struct BitPlane right = bitplane_shift_down(a, 1);
+    struct BitPlane ones, twos;
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        ones.words[i] = a.words[i] ^ left.words[i] ^ right.words[i];
+        twos.words[i] = (a.words[i] & left.words[i]) | (right.words[i] & (a.words[i] ^ left.words[i]));
+    }
+    // then those row sums for the rows above and below, added to this row's (up to 3 + 3 + 3)
+    struct BitPlane ones_up = bitplane_shift_up(ones, board->stride);
+    struct BitPlane twos_up = bitplane_shift_up(twos, board->stride);
+    struct BitPlane ones_down = bitplane_shift_down(ones, board->stride);
+    struct BitPlane twos_down = bitplane_shift_down(twos, board->stride);
+    for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+        // the ones column of all three, carrying into the twos column
+        uint64_t o = ones.words[i], u = ones_up.words[i], d = ones_down.words[i];
+        uint64_t bit0 = o ^ u ^ d;
+        uint64_t carry = (o & u) | (d & (o ^ u));
+        // the twos column: three inputs plus the carry, a sum of up to 4 twos
+        uint64_t t = twos.words[i], tu = twos_up.words[i], td = twos_down.words[i];
+        uint64_t sum = t ^ tu ^ td;
+        uint64_t carry1 = (t & tu) | (td & (t ^ tu));
+        uint64_t bit1 = sum ^ carry;
+        uint64_t carry2 = sum & carry;
+        // carry1 and carry2 are both worth 4, and can both be set (2 + 2 + 2 + 2 = 8)
+        count[0].words[i] = bit0;
+        count[1].words[i] = bit1;
+        count[2].words[i] = carry1 ^ carry2;
+        count[3].words[i] = carry1 & carry2;
+    }
+}
+// tiles where the two counts are the same
+static struct BitPlane bitcount_equal(struct Bitboard *board, const struct BitPlane a[4], const struct BitPlane b[4]) {
+    struct BitPlane differ = {{0}};
+    for (size_t bit = 0; bit < 4; bit++) {
+        for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+            differ.words[i] |= a[bit].words[i] ^ b[bit].words[i];
+        }
+    }
+    return bitplane_andnot(board->valid, differ);
+}
+
+bool bitboard_fits(size_t width, size_t height) {
+    return width > 0 && height > 0 && (width + 1) * height <= BITBOARD_BITS;
+}
+
+bool bitboard_init(struct Bitboard *board, size_t width, size_t height, size_t mines) {
+    if (!bitboard_fits(width, height)) {
+        return false;
+    }
+    memset(board, 0, sizeof(struct Bitboard));
+    board->width = width;
+    board->height = height;
+    board->mines = mines;
+    board->stride = width + 1;
+    // every row is `width` set bits followed by the clear column
+    for (size_t y = 0; y < height; y++) {
+        size_t bit = y * board->stride;
+        size_t end = bit + width;
+        while (bit < end) {
+            size_t len = end - bit < 64 - bit % 64 ? end - bit : 64 - bit % 64;
+            uint64_t mask = len == 64 ? UINT64_MAX : (((uint64_t)1 << len) - 1);
+            board->valid.words[bit / 64] |= mask << (bit % 64);
+            bit += len;
+        }
+    }
+    board->zero = board->valid;
+    return true;
+}
+
+// the counts only change when the mines do
+static void bitboard_update_counts(struct Bitboard *board) {
+    bitboard_count_around(board, board->mine, board->surrounding);
+    struct BitPlane any = board->mine;
+    for (size_t bit = 0; bit < 4; bit++) {
+        any = bitplane_or(any, board->surrounding[bit]);
+    }
+    board->zero = bitplane_andnot(board->valid, any);
+}
+
+static bool bitboard_sample_is_placed(void *ctx, size_t x, size_t y) {
+    struct Bitboard *board = ctx;
+    return bitplane_get(&board->mine, y * board->stride + x);
+}
+static void bitboard_sample_place(void *ctx, size_t x, size_t y) {
+    struct Bitboard *board = ctx;
+    bitplane_set(&board->mine, y * board->stride + x);
+}
+void bitboard_populate(struct Bitboard *board, uint64_t seed, size_t cur_x, size_t cur_y) {
+    struct Rng rng;
+    rng_seed(&rng, seed);
+    minefield_sample_mines(board->width, board->height, board->mines, cur_x, cur_y, &rng,
+                           bitboard_sample_is_placed, bitboard_sample_place, board);
+    bitboard_update_counts(board);
+}
+
+void bitboard_load(struct Bitboard *board, struct Minefield *minefield) {
+    bitboard_init(board, minefield->width, minefield->height, minefield->mines);
+    for (size_t y = 0; y < board->height; y++) {
+        for (size_t x = 0; x < board->width; x++) {
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            size_t bit = y * board->stride + x;
+            if (tile_is_mine(tile)) {
+                bitplane_set(&board->mine, bit);
+            }
+            if (tile_is_visible(tile)) {
+                bitplane_set(&board->visible, bit);
+            }
+            if (tile_is_flagged(tile)) {
+                bitplane_set(&board->flagged, bit);
+            }
+        }
+    }
+    bitboard_update_counts(board);
+}
+
+void bitboard_store(struct Bitboard *board, struct Minefield *minefield) {
+    for (size_t y = 0; y < board->height; y++) {
+        for (size_t x = 0; x < board->width; x++) {
+            size_t bit = y * board->stride + x;
+            uint8_t bits = bitboard_surrounding(board, x, y);
+            bits |= bitplane_get(&board->mine, bit) ? TILE_MINE_BIT : 0;
+            bits |= bitplane_get(&board->visible, bit) ? TILE_VISIBLE_BIT : 0;
+            bits |= bitplane_get(&board->flagged, bit) ? TILE_FLAGGED_BIT : 0;
+            minefield_swap_tile_state(minefield, y * minefield->width + x, &bits);
+        }
+    }
+}
+
+// reveal everything around the newly visible zeroes in `frontier`, and around any zeroes that turns up
+// flags stop it, like in minefield_reveal_tile
+static void bitboard_flood(struct Bitboard *board, struct BitPlane frontier) {
+    frontier = bitplane_and(frontier, board->zero);
+    while (bitplane_any(frontier)) {
+        struct BitPlane grow = bitplane_andnot(bitboard_dilate(board, frontier), bitplane_or(board->visible, board->flagged));
+        board->visible = bitplane_or(board->visible, grow);
+        frontier = bitplane_and(grow, board->zero);
+    }
+}
+
+bool bitboard_reveal(struct Bitboard *board, size_t x, size_t y) {
+    size_t bit = y * board->stride + x;
+    if (bitplane_get(&board->mine, bit)) {
+        return false;
+    }
+    struct BitPlane tile = bitplane_bit(bit);
+    if (!bitplane_get(&board->visible, bit)) {
+        board->visible = bitplane_or(board->visible, tile);
+        bitboard_flood(board, tile);
+        return true;
+    }
+    // already visible, so every hidden unflagged neighbor goes too
+    struct BitPlane around = bitplane_andnot(bitboard_dilate(board, tile), bitplane_or(board->visible, board->flagged));
+    bool no_mines = !bitplane_any(bitplane_and(around, board->mine));
+    around = bitplane_andnot(around, board->mine);
+    board->visible = bitplane_or(board->visible, around);
+    bitboard_flood(board, around);
+    return no_mines;
+}
+
+void bitboard_toggle_flag(struct Bitboard *board, size_t x, size_t y) {
+    size_t bit = y * board->stride + x;
+    if (!bitplane_get(&board->visible, bit)) {
+        bitplane_flip(&board->flagged, bit);
+    }
+}
+
+bool bitboard_check_victory(struct Bitboard *board) {
+    return bitplane_count(bitplane_andnot(board->valid, board->visible)) == board->mines;
+}
+
+uint8_t bitboard_surrounding(struct Bitboard *board, size_t x, size_t y) {
+    size_t bit = y * board->stride + x;
+    uint8_t count = 0;
+    for (size_t i = 0; i < 4; i++) {
+        count |= bitplane_get(&board->surrounding[i], bit) << i;
+    }
+    return count;
+}
+
+size_t bitboard_3bv(struct Bitboard *board, size_t *openings) {
+    size_t clicks = 0;
+    struct BitPlane left = board->zero; // zeroes that aren't part of a counted opening yet
+    struct BitPlane covered = {{0}};
+    while (bitplane_any(left)) {
+        // grow the opening of the lowest zero left until it stops
+        struct BitPlane opening = {{0}};
+        for (size_t i = 0; i < BITBOARD_WORDS; i++) {
+            if (left.words[i]) {
+                opening.words[i] = left.words[i] & -left.words[i];
+                break;
+            }
+        }
+        for (;;) {
+            struct BitPlane grown = bitplane_and(bitboard_dilate(board, opening), board->zero);
+            if (bitplane_count(grown) == bitplane_count(opening)) {
+                break;
+            }
+            opening = grown;
+        }
+        clicks++;
+        left = bitplane_andnot(left, opening);
+        covered = bitplane_or(covered, bitboard_dilate(board, opening));
+    }
+    if (openings) {
+        *openings = clicks;
+    }
+    // every number that isn't next to an opening needs its own click
+    return clicks + bitplane_count(bitplane_andnot(board->valid, bitplane_or(covered, board->mine)));
+}
+
+size_t bitboard_solve(struct Bitboard *board) {
+    size_t revealed = 0;
+    for (;;) {
+        struct BitPlane hidden = bitplane_andnot(board->valid, board->visible);
+        struct BitPlane unknown = bitplane_andnot(hidden, board->solved_mines);
+        if (!bitplane_any(unknown)) {
+            return revealed;
+        }
+        struct BitPlane numbers = bitplane_andnot(board->visible, bitplane_or(board->zero, board->mine));
+        struct BitPlane known_count[4], hidden_count[4];
+        bitboard_count_around(board, board->solved_mines, known_count);
+        bitboard_count_around(board, bitplane_or(board->solved_mines, unknown), hidden_count);
+        // numbers with all their mines found, and numbers where every unknown neighbor has to be one
+        struct BitPlane done = bitplane_and(numbers, bitcount_equal(board, board->surrounding, known_count));
+        struct BitPlane full = bitplane_and(numbers, bitcount_equal(board, board->surrounding, hidden_count));
+        // safe tiles under a flag stay hidden, same as game_autoplay
+        struct BitPlane safe = bitplane_andnot(bitplane_and(bitboard_dilate(board, done), unknown), board->flagged);
+        struct BitPlane mines = bitplane_and(bitboard_dilate(board, full), unknown);
+        if (!bitplane_any(safe) && !bitplane_any(mines)) {
+            return revealed;
+        }
+        board->solved_mines = bitplane_or(board->solved_mines, mines);
+        size_t before = bitplane_count(board->visible);
+        board->visible = bitplane_or(board->visible, safe);
+        bitboard_flood(board, safe);
+        revealed += bitplane_count(board->visible) - before;
+    }
+}
@@ -0,0 +1,24 @@
+#define _POSIX_C_SOURCE 200809L // strcasecmp
+
+#include "difficulty.h"
+
+#include <stddef.h>
+#include <strings.h>
+
+const struct Difficulty difficulties[] = {
+    { "super-easy",   "super_easy", 20, 10, 10 },
+    { "easy",         NULL,         9,  9,  10 },
+    { "intermediate", "medium",     16, 16, 40 },
+    { "hard",         NULL,         30, 16, 99 },
+};
+const size_t difficulties_len = sizeof(difficulties) / sizeof(difficulties[0]);
+
+const struct Difficulty *difficulty_find(const char *name) {
+    for (size_t i = 0; i < difficulties_len; i++) {
+        if (strcasecmp(name, difficulties[i].name) == 0 ||
+            (difficulties[i].alias && strcasecmp(name, difficulties[i].alias) == 0)) {
+            return &difficulties[i];
+        }
+    }
+    return NULL;
+}
@@ -1,15 +1,19 @@
 #include "display.h"
 
 #include "colornames.h"
+#include "display_backend.h"
 #include "game.h"
+#include "infinite.h"
 #include "minefield.h"
 
-#include <ncurses.h>
-
+#include <inttypes.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 
-static const int SCOREBOARD_ROWS = 4;
+static const int SCOREBOARD_ROWS = 5;
+static const int SCOREBOARD_MIN_COLS = 28; // enough for the longest possible seed
+static const int SCROLL_MARGIN = 3; // tiles kept between the cursor and the edge of the view, if there's room
 static const char helptxt[] =
     "H or ?: view this help page\n"
     "L: redraw screen (just in case)\n"
@@ -18,26 +22,35 @@ static const char helptxt[] =
     "r: new game\n"
     "space: reveal tile under cursor\n"
     "f: place flag\n"
-    "u: undo last move (undoing a second time will 'undo the undo')\n"
+    "u: undo last move (needs --allow-undo)\n"
+    "U: redo last undone move\n"
+    "n: jump to a tile that is certainly safe\n"
+    "a: autoplay, reveal and flag everything that is certain\n"
+    "A: autoplay to the end, guessing when stuck\n"
+    "p: show every hidden tile's chance of being a mine (0-9, in tenths)\n"
     "\n"
     "Use hjkl or arrow keys to move\n"
     "0 or ^: jump to left side\n"
     "$: jump to right side\n"
     "g: jump to top side\n"
     "G: jump to bottom side\n"
+    "\n"
+    "With --infinite, only moving, space, f, r and q do anything\n"
 ;
 
+// columns needed to fit everything side to side, including the minefield borders
+static int display_total_width(struct Display *display) {
+    int width = display->view.width * 2 + 2;
+    return width > SCOREBOARD_MIN_COLS ? width : SCOREBOARD_MIN_COLS;
+}
 // set the correct starting position to center the game in the terminal
-// reads from ncurses to figure that out
 static void display_update_origin(struct Display *display) {
-    int scr_rows, scr_cols;
-    getmaxyx(stdscr, scr_rows, scr_cols);
     // add 1 col/row per side for each border, so 2 rows and 2 cols for all 4 borders
-    int width = display->game->minefield.width * 2 + 2;
-    int height = display->game->minefield.height + SCOREBOARD_ROWS * 2;
+    int width = display_total_width(display);
+    int height = display->view.height + SCOREBOARD_ROWS * 2;
 
-    display->origin.x = (scr_cols - width) / 2;
-    display->origin.y = (scr_rows - height) / 2;
+    display->origin.x = (display->cols - width) / 2;
+    display->origin.y = (display->rows - height) / 2;
 
     // prevent from starting off screen in top-left direction
     // TODO: is there a nicer way to do these checks
@@ -48,253 +61,492 @@ static void display_update_origin(struct Display *display) {
         display->origin.y = 0;
     }
 }
-/* destroy_win - delete a window without leaving artifacts on screen
- * Source: https://tldp.org/HOWTO/NCURSES-Programming-HOWTO/windows.html
- */
-static void destroy_win(WINDOW *local_win) {
-    werase(local_win);
-    /* box(local_win, ' ', ' '); : This won't produce the desired
-     * result of erasing the window. It will leave it's four corners
-     * and so an ugly remnant of window.
-     */
-    wborder(local_win, ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ');
-    /* The parameters taken are
-     * 1. win: the window on which to operate
-     * 2. ls: character to be used for the left side of the window
-     * 3. rs: character to be used for the right side of the window
-     * 4. ts: character to be used for the top side of the window
-     * 5. bs: character to be used for the bottom side of the window
-     * 6. tl: character to be used for the top left corner of the window
-     * 7. tr: character to be used for the top right corner of the window
-     * 8. bl: character to be used for the bottom left corner of the window
-     * 9. br: character to be used for the bottom right corner of the window
-     */
-    delwin(local_win);
-}
-static void display_make_windows(struct Display *display) {
-    display->scoreboard = newwin(SCOREBOARD_ROWS, display->game->minefield.width * 2, display->origin.y, display->origin.x);
-
-    // add 2 for borders
-    display->minefield = newwin(display->game->minefield.height + 2, display->game->minefield.width * 2 + 2, display->origin.y + SCOREBOARD_ROWS, display->origin.x);
-
-    display->too_small_popup = newwin(2, COLS, 0, 0);
+// move the view as little as possible to keep the cursor SCROLL_MARGIN tiles inside of it,
+// returns the new start of the view along one axis
+static int64_t display_scroll_unbounded(int64_t start, int size, int64_t cur) {
+    int margin = SCROLL_MARGIN;
+    if (margin > (size - 1) / 2) {
+        margin = (size - 1) / 2;
+    }
+    if (cur < start + margin) {
+        start = cur - margin;
+    } else if (cur >= start + size - margin) {
+        start = cur - size + margin + 1;
+    }
+    return start;
+}
+// same, without going past the edges of a board `total` tiles long
+static int display_scroll(int start, int size, int total, int cur) {
+    int64_t scrolled = display_scroll_unbounded(start, size, cur);
+    if (scrolled > total - size) {
+        scrolled = total - size;
+    }
+    if (scrolled < 0) {
+        scrolled = 0;
+    }
+    return scrolled;
+}
+static void display_follow_cursor(struct Display *display) {
+    if (display->infinite.field) {
+        struct InfiniteField *field = display->infinite.field;
+        display->infinite.x = display_scroll_unbounded(display->infinite.x, display->view.width, field->cur.x);
+        display->infinite.y = display_scroll_unbounded(display->infinite.y, display->view.height, field->cur.y);
+        return;
+    }
+    struct Minefield *minefield = &display->game->minefield;
+    int x = display_scroll(display->view.x, display->view.width, minefield->width, minefield->cur.x);
+    int y = display_scroll(display->view.y, display->view.height, minefield->height, minefield->cur.y);
+    if (x != display->view.x || y != display->view.y) {
+        display->view.x = x;
+        display->view.y = y;
+        display->repaint_needed = true;
+    }
+}
+// fit as much of the minefield on the screen as possible
+static void display_update_view(struct Display *display) {
+    int width = (display->cols - 2) / 2; // minus 2 for borders
+    int height = display->rows - SCOREBOARD_ROWS - 2;
+    if (display->infinite.field) {
+        // always more board than screen
+        display->view.width = width;
+        display->view.height = height;
+    } else {
+        struct Minefield *minefield = &display->game->minefield;
+        display->view.width = width < (int)minefield->width ? width : (int)minefield->width;
+        display->view.height = height < (int)minefield->height ? height : (int)minefield->height;
+    }
+    if (display->view.width < 1) {
+        display->view.width = 1;
+    }
+    if (display->view.height < 1) {
+        display->view.height = 1;
+    }
+    display->repaint_needed = true;
+    display_follow_cursor(display);
 }
 static void display_set_min_size(struct Display *display) {
-    // check if terminal is too small
-    display->min_width = display->game->minefield.width * 2 + 2;
-    display->min_height = SCOREBOARD_ROWS + display->game->minefield.height + 2; // add 2 for borders
-    if (COLS < display->min_width || LINES < display->min_height) {
+    // check if terminal is too small; the minefield scrolls, but at least one row of it has to fit
+    display->min_width = SCOREBOARD_MIN_COLS;
+    display->min_height = SCOREBOARD_ROWS + 1 + 2; // add 2 for borders
+    if (display->cols < display->min_width || display->rows < display->min_height) {
         display->too_small = true;
     } else {
         display->too_small = false;
     }
 }
 // recalculate everything if the terminal is resized
-// TODO: maybe store Minefield somewhere in Display so it's not an arg
 // TODO: should this be `display_reset` instead?
 void display_resize(struct Display *display) {
     display->erase_needed = true;
 
-    destroy_win(display->scoreboard);
-    destroy_win(display->minefield);
-    destroy_win(display->too_small_popup);
-
-    endwin(); // make ncurses recalculate stuff like global vars LINES and COLS
+    display->backend.ops->get_size(display->backend.ctx, &display->rows, &display->cols);
     display_set_min_size(display);
+    display_update_view(display);
     display_update_origin(display);
-    display_make_windows(display);
 }
 
-bool display_init(struct Display *display) {
-    // ncurses setup
-    initscr();
-    if (!has_colors()) {
-        endwin();
-        printf("smines requires color support in your terminal to work properly.\n");
-        return false;
-    }
-    keypad(stdscr, TRUE); // arrow keys
-    noecho(); // don't show letter on key press
-    curs_set(0); // make cursor invisible
-    start_color();
-    use_default_colors(); // allows extra colors such as terminal background color
-
-    // set up color pairs
-    // init_pair(id, fg, bg);
-    init_pair(TILE_ZERO, COLOR_WHITE, COLOR_BLACK);
-    init_pair(TILE_MINE, COLOR_RED, COLOR_BLACK);
-    init_pair(TILE_MINE_SAFE, COLOR_GREEN, COLOR_BLACK);
-
-    init_pair(TILE_ONE, COLOR_WHITE, COLOR_BLUE);
-    init_pair(TILE_TWO, COLOR_BLACK, COLOR_GREEN);
-    init_pair(TILE_THREE, COLOR_WHITE, COLOR_RED);
-    init_pair(TILE_FOUR, COLOR_BLACK, COLOR_CYAN);
-    init_pair(TILE_FIVE, COLOR_WHITE, 94);
-    init_pair(TILE_SIX, COLOR_BLACK, COLOR_MAGENTA);
-    init_pair(TILE_SEVEN, COLOR_WHITE, COLOR_BLACK);
-    init_pair(TILE_EIGHT, COLOR_WHITE, COLOR_LIGHT_BLACK);
-
-    init_pair(TILE_HIDDEN, COLOR_LIGHT_BLACK, -1);
-    init_pair(TILE_FLAG, COLOR_YELLOW, COLOR_BLACK);
-    init_pair(TILE_FLAG_WRONG, COLOR_BLUE, COLOR_BLACK);
-    init_pair(TILE_CURSOR, COLOR_BLACK, COLOR_WHITE);
-
-    init_pair(TILE_ERROR, COLOR_WHITE, COLOR_RED);
-
-    init_pair(MSG_DEATH, COLOR_RED, -1);
-    init_pair(MSG_WIN, COLOR_GREEN, -1);
-
+bool display_init(struct Display *display, struct DisplayBackend backend) {
     *display = (struct Display){0};
+    display->backend = backend;
+    display->backend.ops->get_size(display->backend.ctx, &display->rows, &display->cols);
     return true;
 }
 
-void display_set_game(struct Display *display, struct Game *game) {
-    display->game = game;
-    display_set_min_size(display);
-    display_update_origin(display);
-    display_make_windows(display);
+void display_destroy(struct Display *display) {
+    free(display->row_cells);
+    display->backend.ops->destroy(display->backend.ctx);
 }
 
-void display_destroy(struct Display *display) {
-    endwin();
+int display_get_key(struct Display *display) {
+    return display->backend.ops->get_key(display->backend.ctx);
+}
+
+int display_poll_key(struct Display *display, int timeout_ms) {
+    return display->backend.ops->poll_key(display->backend.ctx, timeout_ms);
 }
 
 // get color pair needed to draw a tile with a specific amount of surrounding mines
 static int get_surround_color(int surrounding) {
     if (surrounding == 0) {
-        return COLOR_PAIR(10);
+        return TILE_ZERO;
     } else if ((surrounding <= 8) && (surrounding >= 1)) { // 1 <= surrounding <= 8
-        return COLOR_PAIR(surrounding);
+        return surrounding;
     } else {
-        return COLOR_PAIR(100);
+        return TILE_ERROR;
     }
 }
-static void display_draw_tile_text(struct Display *display, struct Tile *tile, int x, int y) {
-    WINDOW *win = display->minefield;
-    wmove(win, y + 1, x * 2 + 1); // add 1 because of border? TODO: verify this
-    if (tile->flagged) {
-        wattron(win, A_BOLD);
-        if (display->game->state == DEAD && !tile->mine) {
-            wprintw(win, "!F");
+// the state the tiles and scoreboard are drawn for
+static enum GameState display_game_state(struct Display *display) {
+    return display->infinite.field ? *display->infinite.state : display->game->state;
+}
+
+// the two cells a tile is drawn with, only used to fill in display->tile_cells
+static void display_tile_cells(struct Display *display, struct Tile *tile, struct Cell cells[2]) {
+    enum GameState state = display_game_state(display);
+    uint8_t color;
+    uint8_t attr = 0;
+    char ch;
+    cells[0].ch = ' ';
+    if (tile_is_flagged(tile)) {
+        attr = CELL_BOLD;
+        ch = 'F';
+        if (state == VICTORY) {
+            color = TILE_MINE_SAFE;
+        } else if ((state == DEAD) && (!tile_is_mine(tile))) {
+            color = TILE_FLAG_WRONG;
+            cells[0].ch = '!';
         } else {
-            wprintw(win, " F");
+            color = TILE_FLAG;
         }
-        wattroff(win, A_BOLD);
-    } else if (tile->visible) {
-        if (tile->mine) {
-            wattron(win, A_BOLD);
-            wprintw(win, " X");
-            wattroff(win, A_BOLD);
+    } else if (tile_is_visible(tile)) {
+        if (tile_is_mine(tile)) {
+            attr = CELL_BOLD;
+            ch = 'X';
+            color = state == VICTORY ? TILE_MINE_SAFE : TILE_MINE;
         } else {
-            if (tile->surrounding == 0) {
-                wprintw(win, "  ");
-            } else {
-                wprintw(win, " %i", tile->surrounding);
-            }
+            ch = tile_surrounding(tile) == 0 ? ' ' : '0' + tile_surrounding(tile);
+            color = get_surround_color(tile_surrounding(tile));
         }
     } else {
-        wprintw(win, " ?");
+        ch = '?';
+        color = TILE_HIDDEN;
+    }
+    cells[0].color = cells[1].color = color;
+    cells[0].attr = cells[1].attr = attr;
+    cells[1].ch = ch;
+}
+static void display_build_tile_cells(struct Display *display) {
+    for (int bits = 0; bits < TILE_DIRTY_BIT; bits++) {
+        struct Tile tile = { bits };
+        display_tile_cells(display, &tile, display->tile_cells[bits]);
+    }
+}
+// the two cells a hidden tile is drawn with on the heatmap: its chance of being a mine in tenths
+static void display_heat_cells(float chance, struct Cell cells[2]) {
+    uint8_t color;
+    char ch;
+    if (chance <= 0) {
+        color = HEAT_SAFE;
+        ch = '0';
+    } else if (chance >= 1) {
+        color = HEAT_MINE;
+        ch = '*';
+    } else {
+        int tenths = chance * 10;
+        color = chance < 0.2 ? HEAT_LOW : chance < 0.5 ? HEAT_MEDIUM : HEAT_HIGH;
+        ch = '0' + (tenths > 9 ? 9 : tenths);
     }
+    cells[0].ch = ' ';
+    cells[1].ch = ch;
+    cells[0].color = cells[1].color = color;
+    cells[0].attr = cells[1].attr = 0;
+}
+static bool display_showing_heatmap(struct Display *display) {
+    return display->heatmap && display->game->state == ALIVE && display->game->probability.tiles;
+}
+static inline const struct Cell *display_lookup_tile(struct Display *display, struct Tile *tile, int x, int y) {
+    if (!tile_is_visible(tile) && !tile_is_flagged(tile) && display_showing_heatmap(display)) {
+        struct Minefield *minefield = &display->game->minefield;
+        display_heat_cells(display->game->probability.tiles[y * minefield->width + x], display->heat_cells);
+        return display->heat_cells;
+    }
+    return display->tile_cells[tile->bits & ~TILE_DIRTY_BIT];
+}
+
+void display_set_game(struct Display *display, struct Game *game) {
+    display->infinite.field = NULL;
+    display->game = game;
+    display->repaint_needed = true;
+    display->drawn_state = game->state;
+    display_build_tile_cells(display);
+    display->view.x = display->view.y = 0;
+    display_set_min_size(display);
+    display_update_view(display);
+    display_update_origin(display);
+}
+
+void display_set_infinite(struct Display *display, struct InfiniteField *field, const enum GameState *state) {
+    display->game = NULL;
+    display->heatmap = false; // nothing works out the chances on an endless board
+    display->infinite.field = field;
+    display->infinite.state = state;
+    display->repaint_needed = true;
+    display->drawn_state = *state;
+    display_build_tile_cells(display);
+    // tile positions on the screen are worked out from view.x/y, which stay put; infinite.x/y scroll
+    display->view.x = display->view.y = 0;
+    display_set_min_size(display);
+    display_update_view(display);
+    // start with the cursor in the middle
+    display->infinite.x = field->cur.x - display->view.width / 2;
+    display->infinite.y = field->cur.y - display->view.height / 2;
+    display_update_origin(display);
+}
+
+// screen position of a tile in the view; add 1 because of the border
+static int display_tile_row(struct Display *display, int y) {
+    return display->origin.y + SCOREBOARD_ROWS + 1 + y - display->view.y;
+}
+static int display_tile_col(struct Display *display, int x) {
+    return display->origin.x + 1 + (x - display->view.x) * 2;
+}
+static bool display_tile_in_view(struct Display *display, int x, int y) {
+    return x >= display->view.x && x < display->view.x + display->view.width &&
+           y >= display->view.y && y < display->view.y + display->view.height;
 }
 static void display_draw_tile(struct Display *display, struct Tile *tile, int x, int y) {
-    int color;
-    // get the color pair to draw with
-    if (tile->flagged) {
-        if (display->game->state == VICTORY) {
-            color = COLOR_PAIR(TILE_MINE_SAFE);
-        } else if ((display->game->state == DEAD) && (!tile->mine)) {
-            color = COLOR_PAIR(TILE_FLAG_WRONG);
-        } else {
-            color = COLOR_PAIR(TILE_FLAG);
+    display->backend.ops->put_cells(display->backend.ctx, display_tile_row(display, y), display_tile_col(display, x),
+                                    display_lookup_tile(display, tile, x, y), 2);
+}
+// make room for a row of the view in display->row_cells, false if there wasn't memory for it
+static bool display_reserve_row(struct Display *display) {
+    size_t len = display->view.width * 2;
+    if (len > display->row_cells_cap) {
+        struct Cell *row_cells = realloc(display->row_cells, len * sizeof(struct Cell));
+        if (!row_cells) {
+            return false;
         }
-    } else if (tile->visible) {
-        if (tile->mine) {
-            color = COLOR_PAIR(display->game->state == VICTORY ? TILE_MINE_SAFE : TILE_MINE);
-        } else {
-            color = get_surround_color(tile->surrounding);
+        display->row_cells = row_cells;
+        display->row_cells_cap = len;
+    }
+    return true;
+}
+// draw the part of a row that's in the view with one put_cells
+static void display_draw_row(struct Display *display, int y) {
+    struct Minefield *minefield = &display->game->minefield;
+    int start = display->view.x;
+    int end = display->view.x + display->view.width;
+    size_t len = display->view.width * 2;
+    if (!display_reserve_row(display)) {
+        // fall back to one tile at a time
+        for (int x = start; x < end; x++) {
+            display_draw_tile(display, minefield_get_tile(minefield, x, y), x, y);
         }
-    } else {
-        color = COLOR_PAIR(TILE_HIDDEN);
+        return;
+    }
+    struct Cell *cells = display->row_cells;
+    for (int x = start; x < end; x++) {
+        const struct Cell *tile_cells = display_lookup_tile(display, minefield_get_tile(minefield, x, y), x, y);
+        cells[(x - start) * 2] = tile_cells[0];
+        cells[(x - start) * 2 + 1] = tile_cells[1];
     }
-    wattron(display->minefield, color);
-    display_draw_tile_text(display, tile, x, y);
-    wattroff(display->minefield, color);
+    display->backend.ops->put_cells(display->backend.ctx, display_tile_row(display, y), display_tile_col(display, start), cells, len);
 }
 
 static void display_draw_minefield(struct Display *display) {
-    for (int y = 0; y < display->game->minefield.height; y++) {
-        for (int x = 0; x < display->game->minefield.width; x++) {
-            display_draw_tile(display, minefield_get_tile(&display->game->minefield, x, y), x, y);
+    struct Minefield *minefield = &display->game->minefield;
+    display_follow_cursor(display);
+    // dying or winning changes how flags and mines look without touching the tiles themselves
+    if (display->game->state != display->drawn_state) {
+        display->repaint_needed = true;
+        display->drawn_state = display->game->state;
+        display_build_tile_cells(display);
+    }
+    // new probabilities can change any hidden tile
+    if (display_showing_heatmap(display) && display->game->probability.generation != display->drawn_generation) {
+        display->repaint_needed = true;
+        display->drawn_generation = display->game->probability.generation;
+    }
+    if (display->repaint_needed || minefield->dirty.all) {
+        for (int y = display->view.y; y < display->view.y + display->view.height; y++) {
+            display_draw_row(display, y);
+        }
+        // add 2 for borders
+        display->backend.ops->draw_box(display->backend.ctx, display->origin.y + SCOREBOARD_ROWS, display->origin.x,
+                                       display->view.height + 2, display->view.width * 2 + 2);
+        display->repaint_needed = false;
+    } else {
+        for (size_t i = 0; i < minefield->dirty.len; i++) {
+            int x = minefield->dirty.items[i] % minefield->width;
+            int y = minefield->dirty.items[i] / minefield->width;
+            if (display_tile_in_view(display, x, y)) {
+                display_draw_tile(display, minefield_get_tile(minefield, x, y), x, y);
+            }
         }
     }
+    minefield_clear_dirty(minefield);
 
     // draw the cursor
-    int cur_x = display->game->minefield.cur.x;
-    int cur_y = display->game->minefield.cur.y;
-    wmove(display->minefield, cur_y + 1, cur_x * 2 + 1); // add 1 because of border? TODO: verify this
-    wattron(display->minefield, COLOR_PAIR(TILE_CURSOR));
-    display_draw_tile_text(display, minefield_get_tile(&display->game->minefield, cur_x, cur_y), cur_x, cur_y);
-    wattroff(display->minefield, COLOR_PAIR(TILE_CURSOR));
-    
-    wborder(display->minefield, 0, 0, 0, 0, 0, 0, 0, 0);
+    int cur_x = minefield->cur.x;
+    int cur_y = minefield->cur.y;
+    struct Cell cells[2];
+    const struct Cell *tile_cells = display_lookup_tile(display, minefield_get_tile(minefield, cur_x, cur_y), cur_x, cur_y);
+    cells[0] = tile_cells[0];
+    cells[1] = tile_cells[1];
+    cells[0].color = cells[1].color = TILE_CURSOR;
+    display->backend.ops->put_cells(display->backend.ctx, display_tile_row(display, cur_y), display_tile_col(display, cur_x), cells, 2);
 }
 
-static void display_draw_scoreboard(struct Display *display) {
-    WINDOW *win = display->scoreboard;
-    werase(win); // if we don't clear, and the new text is shorter than the old text, characters are left on screen
+// the cells a tile of the infinite board is drawn with
+static const struct Cell *display_infinite_cells(struct Display *display, int64_t x, int64_t y) {
+    // looking at a tile makes its chunk; one there wasn't memory for is shown as hidden
+    struct Tile *tile = infinite_get_tile(display->infinite.field, x, y);
+    if (!tile) {
+        return display->tile_cells[0];
+    }
+    uint8_t bits = tile->bits & ~TILE_DIRTY_BIT;
+    // an endless board's mines can't all be revealed when the game's lost, so the ones in view are shown
+    if (*display->infinite.state == DEAD && tile_is_mine(tile)) {
+        bits |= TILE_VISIBLE_BIT;
+    }
+    return display->tile_cells[bits];
+}
+static void display_draw_infinite(struct Display *display) {
+    struct InfiniteField *field = display->infinite.field;
+    display_follow_cursor(display);
+    if (*display->infinite.state != display->drawn_state) {
+        display->drawn_state = *display->infinite.state;
+        display_build_tile_cells(display);
+    }
+    bool whole_rows = display_reserve_row(display);
+    for (int y = 0; y < display->view.height; y++) {
+        for (int x = 0; x < display->view.width; x++) {
+            const struct Cell *tile_cells = display_infinite_cells(display, display->infinite.x + x,
+                                                                   display->infinite.y + y);
+            if (whole_rows) {
+                display->row_cells[x * 2] = tile_cells[0];
+                display->row_cells[x * 2 + 1] = tile_cells[1];
+            } else {
+                display->backend.ops->put_cells(display->backend.ctx, display_tile_row(display, y),
+                                                display_tile_col(display, x), tile_cells, 2);
+            }
+        }
+        if (whole_rows) {
+            display->backend.ops->put_cells(display->backend.ctx, display_tile_row(display, y),
+                                            display_tile_col(display, 0), display->row_cells, display->view.width * 2);
+        }
+    }
+    if (display->repaint_needed) {
+        display->backend.ops->draw_box(display->backend.ctx, display->origin.y + SCOREBOARD_ROWS, display->origin.x,
+                                       display->view.height + 2, display->view.width * 2 + 2);
+        display->repaint_needed = false;
+    }
+
+    // draw the cursor, which following it keeps in the view
+    int cur_x = field->cur.x - display->infinite.x;
+    int cur_y = field->cur.y - display->infinite.y;
+    struct Cell cells[2];
+    const struct Cell *tile_cells = display_infinite_cells(display, field->cur.x, field->cur.y);
+    cells[0] = tile_cells[0];
+    cells[1] = tile_cells[1];
+    cells[0].color = cells[1].color = TILE_CURSOR;
+    display->backend.ops->put_cells(display->backend.ctx, display_tile_row(display, cur_y), display_tile_col(display, cur_x), cells, 2);
+}
+
+// the scoreboard lines under the top one
+static void display_draw_game_scoreboard(struct Display *display) {
+    const struct DisplayBackendOps *ops = display->backend.ops;
+    void *ctx = display->backend.ctx;
+    int x = display->origin.x;
+    int y = display->origin.y;
+    char line[64];
     size_t mines = display->game->minefield.mines;
     size_t placed = display->game->minefield.placed_flags;
     int found_percentage = ((float)placed / (float)mines) * 100;
-    mvwprintw(win, 1, 0, "Game #%i (%lix%li)", display->game_number, display->game->minefield.width, display->game->minefield.height);
-    mvwprintw(win, 2, 0, "Flags: %li", placed);
-    mvwprintw(win, 3, 0, "Mines: %li/%li (%i%%)", mines - placed, mines, found_percentage);
+    snprintf(line, sizeof(line), "Game #%i (%zux%zu)", display->game_number, display->game->minefield.width, display->game->minefield.height);
+    ops->put_text(ctx, y + 1, x, line, 0, 0);
+    if (display->game->minefield.openings.built) {
+        snprintf(line, sizeof(line), "Flags: %zu  3BV: %zu", placed, display->game->minefield.openings.bv3);
+    } else {
+        snprintf(line, sizeof(line), "Flags: %zu", placed);
+    }
+    ops->put_text(ctx, y + 2, x, line, 0, 0);
+    snprintf(line, sizeof(line), "Mines: %zu/%zu (%i%%)", mines - placed, mines, found_percentage);
+    ops->put_text(ctx, y + 3, x, line, 0, 0);
+    snprintf(line, sizeof(line), "Seed: %" PRIu64, display->game->minefield.seed);
+    ops->put_text(ctx, y + 4, x, line, 0, 0);
+}
+// the same for the infinite board, which has no size or mine count
+static void display_draw_infinite_scoreboard(struct Display *display) {
+    const struct DisplayBackendOps *ops = display->backend.ops;
+    void *ctx = display->backend.ctx;
+    struct InfiniteField *field = display->infinite.field;
+    int x = display->origin.x;
+    int y = display->origin.y;
+    char line[64];
+    snprintf(line, sizeof(line), "Game #%i (infinite)", display->game_number);
+    ops->put_text(ctx, y + 1, x, line, 0, 0);
+    snprintf(line, sizeof(line), "Flags: %zu  Revealed: %zu", field->placed_flags, field->visible_tiles);
+    ops->put_text(ctx, y + 2, x, line, 0, 0);
+    snprintf(line, sizeof(line), "Position: %" PRId64 ", %" PRId64, field->cur.x, field->cur.y);
+    ops->put_text(ctx, y + 3, x, line, 0, 0);
+    snprintf(line, sizeof(line), "Seed: %" PRIu64, field->seed);
+    ops->put_text(ctx, y + 4, x, line, 0, 0);
+}
+
+static void display_draw_scoreboard(struct Display *display) {
+    const struct DisplayBackendOps *ops = display->backend.ops;
+    void *ctx = display->backend.ctx;
+    int x = display->origin.x;
+    int y = display->origin.y;
+    // if we don't clear, and the new text is shorter than the old text, characters are left on screen
+    ops->clear_rect(ctx, y, x, SCOREBOARD_ROWS, display_total_width(display));
+
+    if (display->infinite.field) {
+        display_draw_infinite_scoreboard(display);
+    } else {
+        display_draw_game_scoreboard(display);
+    }
 
     // TODO: somehow this doesnt work on first frame until keypress when window is close to not fitting
-    switch (display->game->state) { // draw the top line
+    switch (display_game_state(display)) { // draw the top line
         case ALIVE:
-            wattron(win, A_BOLD);
-            mvwprintw(win, 0, 0, "Press ? for help");
-            wattroff(win, A_BOLD);
+            ops->put_text(ctx, y, x, display->status ? display->status : "Press ? for help", 0, CELL_BOLD);
             break;
         case VICTORY:
-            wattron(win, A_BOLD);
-            wattron(win, COLOR_PAIR(MSG_WIN));
-            mvwprintw(win, 0, 0, "YOU WIN!");
-            wattroff(win, COLOR_PAIR(MSG_WIN));
-            wattroff(win, A_BOLD);
+            ops->put_text(ctx, y, x, "YOU WIN!", MSG_WIN, CELL_BOLD);
             break;
         case DEAD:
-            wattron(win, A_BOLD);
-            wattron(win, COLOR_PAIR(MSG_DEATH));
-            mvwprintw(win, 0, 0, "YOU DIED!");
-            wattroff(win, COLOR_PAIR(MSG_DEATH));
-            wattroff(win, A_BOLD);
+            ops->put_text(ctx, y, x, "YOU DIED!", MSG_DEATH, CELL_BOLD);
             break;
         default:
             abort();
     }
+    if (display->status && display_game_state(display) != ALIVE) {
+        ops->put_text(ctx, y, x + 10, display->status, 0, 0);
+    }
+}
+
+static void display_draw_help(struct Display *display) {
+    // put_text doesn't do newlines, so go line by line
+    char line[128];
+    const char *start = helptxt;
+    for (int y = 0; *start; y++) {
+        const char *end = start;
+        while (*end && *end != '\n') {
+            end++;
+        }
+        snprintf(line, sizeof(line), "%.*s", (int)(end - start), start);
+        display->backend.ops->put_text(display->backend.ctx, y, 0, line, 0, 0);
+        start = *end ? end + 1 : end;
+    }
 }
 
 void display_draw(struct Display *display) {
     if (display->erase_needed) {
-        erase();
+        display->backend.ops->erase(display->backend.ctx);
         display->erase_needed = false;
+        display->repaint_needed = true;
     }
     if (display->too_small) {
-        wmove(display->too_small_popup, 0, 0);
-        // TODO: make a window to display this so it overlays
-        wprintw(display->too_small_popup, "Please make your terminal at least %i cols by %i rows\n", display->min_width, display->min_height);
-        wprintw(display->too_small_popup, "Current size: %i cols by %i rows", COLS, LINES);
-        //wrefresh(display->too_small_popup);
+        char line[96];
+        snprintf(line, sizeof(line), "Please make your terminal at least %i cols by %i rows", display->min_width, display->min_height);
+        display->backend.ops->put_text(display->backend.ctx, 0, 0, line, 0, 0);
+        snprintf(line, sizeof(line), "Current size: %i cols by %i rows", display->cols, display->rows);
+        display->backend.ops->put_text(display->backend.ctx, 1, 0, line, 0, 0);
         return;
     }
 
     switch (display->state) {
         case HELP:
-            mvprintw(0, 0, helptxt);
+            display_draw_help(display);
             break;
         case GAME:
-            display_draw_minefield(display);
+            if (display->infinite.field) {
+                display_draw_infinite(display);
+            } else {
+                display_draw_minefield(display);
+            }
             display_draw_scoreboard(display);
             break;
         default:
@@ -303,10 +555,12 @@ void display_draw(struct Display *display) {
 }
 
 void display_refresh(struct Display *display) {
-    refresh();
-    wrefresh(display->scoreboard);
-    wrefresh(display->minefield);
-    wrefresh(display->too_small_popup);
+    display->backend.ops->refresh(display->backend.ctx);
+}
+
+void display_toggle_heatmap(struct Display *display) {
+    display->heatmap = !display->heatmap;
+    display->repaint_needed = true;
 }
 
 void display_transition_help(struct Display *display) {
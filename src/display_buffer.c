@@ -0,0 +1,159 @@
+#include "display_backend.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct BufferBackend {
+    int rows, cols;
+    struct Cell *cells;
+    const char *keys; // what's left of the key script
+};
+
+static const struct Cell BLANK = { ' ', 0, 0 };
+
+static void buffer_destroy(void *ctx) {
+    struct BufferBackend *buffer = ctx;
+    free(buffer->cells);
+    free(buffer);
+}
+
+static void buffer_get_size(void *ctx, int *rows, int *cols) {
+    struct BufferBackend *buffer = ctx;
+    *rows = buffer->rows;
+    *cols = buffer->cols;
+}
+
+static void buffer_clear_rect(void *ctx, int y, int x, int height, int width) {
+    struct BufferBackend *buffer = ctx;
+    for (int row = y < 0 ? 0 : y; row < y + height && row < buffer->rows; row++) {
+        for (int col = x < 0 ? 0 : x; col < x + width && col < buffer->cols; col++) {
+            buffer->cells[row * buffer->cols + col] = BLANK;
+        }
+    }
+}
+
+static void buffer_erase(void *ctx) {
+    struct BufferBackend *buffer = ctx;
+    buffer_clear_rect(ctx, 0, 0, buffer->rows, buffer->cols);
+}
+
+static void buffer_put_cells(void *ctx, int y, int x, const struct Cell *cells, int n) {
+    struct BufferBackend *buffer = ctx;
+    if (y < 0 || y >= buffer->rows) {
+        return;
+    }
+    // clip to the screen
+    if (x < 0) {
+        cells -= x;
+        n += x;
+        x = 0;
+    }
+    if (x + n > buffer->cols) {
+        n = buffer->cols - x;
+    }
+    if (n > 0) {
+        memcpy(&buffer->cells[y * buffer->cols + x], cells, n * sizeof(struct Cell));
+    }
+}
+
+static void buffer_put_text(void *ctx, int y, int x, const char *text, uint8_t color, uint8_t attr) {
+    struct BufferBackend *buffer = ctx;
+    for (; *text && x < buffer->cols; text++, x++) {
+        struct Cell cell = { *text, color, attr };
+        buffer_put_cells(ctx, y, x, &cell, 1);
+    }
+}
+
+static void buffer_draw_box(void *ctx, int y, int x, int height, int width) {
+    struct Cell corner = { '+', 0, 0 };
+    struct Cell horizontal = { '-', 0, 0 };
+    struct Cell vertical = { '|', 0, 0 };
+    buffer_put_cells(ctx, y, x, &corner, 1);
+    buffer_put_cells(ctx, y, x + width - 1, &corner, 1);
+    buffer_put_cells(ctx, y + height - 1, x, &corner, 1);
+    buffer_put_cells(ctx, y + height - 1, x + width - 1, &corner, 1);
+    for (int col = x + 1; col < x + width - 1; col++) {
+        buffer_put_cells(ctx, y, col, &horizontal, 1);
+        buffer_put_cells(ctx, y + height - 1, col, &horizontal, 1);
+    }
+    for (int row = y + 1; row < y + height - 1; row++) {
+        buffer_put_cells(ctx, row, x, &vertical, 1);
+        buffer_put_cells(ctx, row, x + width - 1, &vertical, 1);
+    }
+}
+
+static void buffer_refresh(void *ctx) {
+    // the buffer is always up to date
+    (void)ctx;
+}
+
+static int buffer_get_key(void *ctx) {
+    struct BufferBackend *buffer = ctx;
+    if (!buffer->keys || *buffer->keys == '\0') {
+        return DISPLAY_KEY_EOF;
+    }
+    return (unsigned char)*buffer->keys++;
+}
+
+static int buffer_poll_key(void *ctx, int timeout_ms) {
+    (void)timeout_ms;
+    int key = buffer_get_key(ctx);
+    return key == DISPLAY_KEY_EOF ? DISPLAY_KEY_NONE : key;
+}
+
+static const struct DisplayBackendOps buffer_ops = {
+    .destroy = buffer_destroy,
+    .get_size = buffer_get_size,
+    .erase = buffer_erase,
+    .clear_rect = buffer_clear_rect,
+    .put_cells = buffer_put_cells,
+    .put_text = buffer_put_text,
+    .draw_box = buffer_draw_box,
+    .refresh = buffer_refresh,
+    .get_key = buffer_get_key,
+    .poll_key = buffer_poll_key,
+};
+
+bool display_backend_buffer_init(struct DisplayBackend *backend, int rows, int cols, const char *keys) {
+    struct BufferBackend *buffer = malloc(sizeof(struct BufferBackend));
+    if (!buffer) {
+        return false;
+    }
+    buffer->rows = rows;
+    buffer->cols = cols;
+    buffer->keys = keys;
+    buffer->cells = malloc((size_t)rows * cols * sizeof(struct Cell));
+    if (!buffer->cells) {
+        free(buffer);
+        return false;
+    }
+    buffer_erase(buffer);
+
+    backend->ops = &buffer_ops;
+    backend->ctx = buffer;
+    return true;
+}
+
+const struct Cell *display_backend_buffer_cells(struct DisplayBackend *backend, int *rows, int *cols) {
+    struct BufferBackend *buffer = backend->ctx;
+    *rows = buffer->rows;
+    *cols = buffer->cols;
+    return buffer->cells;
+}
+
+void display_backend_buffer_dump(struct DisplayBackend *backend, FILE *file) {
+    struct BufferBackend *buffer = backend->ctx;
+    for (int row = 0; row < buffer->rows; row++) {
+        // leave out trailing spaces
+        int len = buffer->cols;
+        while (len > 0 && buffer->cells[row * buffer->cols + len - 1].ch == ' ') {
+            len--;
+        }
+        for (int col = 0; col < len; col++) {
+            fputc(buffer->cells[row * buffer->cols + col].ch, file);
+        }
+        fputc('\n', file);
+    }
+}
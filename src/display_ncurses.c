@@ -0,0 +1,201 @@
+#include "display_backend.h"
+
+#include "colornames.h"
+
+#include <ncurses.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct NcursesBackend {
+    // put_cells converts into this and hands the whole thing to ncurses at once
+    chtype *line;
+    int line_cap;
+};
+
+static void ncurses_destroy(void *ctx) {
+    struct NcursesBackend *backend = ctx;
+    endwin();
+    free(backend->line);
+    free(backend);
+}
+
+static void ncurses_get_size(void *ctx, int *rows, int *cols) {
+    (void)ctx;
+    getmaxyx(stdscr, *rows, *cols);
+}
+
+static void ncurses_erase(void *ctx) {
+    (void)ctx;
+    erase();
+}
+
+static void ncurses_clear_rect(void *ctx, int y, int x, int height, int width) {
+    (void)ctx;
+    for (int row = y; row < y + height; row++) {
+        mvhline(row, x, ' ', width);
+    }
+}
+
+static attr_t ncurses_attrs(uint8_t color, uint8_t attr) {
+    attr_t attrs = COLOR_PAIR(color);
+    if (attr & CELL_BOLD) {
+        attrs |= A_BOLD;
+    }
+    return attrs;
+}
+
+static void ncurses_put_cells(void *ctx, int y, int x, const struct Cell *cells, int n) {
+    struct NcursesBackend *backend = ctx;
+    if (n > backend->line_cap) {
+        chtype *line = realloc(backend->line, n * sizeof(chtype));
+        if (!line) {
+            return;
+        }
+        backend->line = line;
+        backend->line_cap = n;
+    }
+    // neighboring cells almost always look the same, so only redo the attributes when they change
+    attr_t attrs = ncurses_attrs(cells[0].color, cells[0].attr);
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && (cells[i].color != cells[i - 1].color || cells[i].attr != cells[i - 1].attr)) {
+            attrs = ncurses_attrs(cells[i].color, cells[i].attr);
+        }
+        backend->line[i] = (unsigned char)cells[i].ch | attrs;
+    }
+    mvaddchnstr(y, x, backend->line, n);
+}
+
+static void ncurses_put_text(void *ctx, int y, int x, const char *text, uint8_t color, uint8_t attr) {
+    (void)ctx;
+    attr_t attrs = ncurses_attrs(color, attr);
+    attron(attrs);
+    mvaddstr(y, x, text);
+    attroff(attrs);
+}
+
+static void ncurses_draw_box(void *ctx, int y, int x, int height, int width) {
+    (void)ctx;
+    mvaddch(y, x, ACS_ULCORNER);
+    mvhline(y, x + 1, ACS_HLINE, width - 2);
+    mvaddch(y, x + width - 1, ACS_URCORNER);
+    mvvline(y + 1, x, ACS_VLINE, height - 2);
+    mvvline(y + 1, x + width - 1, ACS_VLINE, height - 2);
+    mvaddch(y + height - 1, x, ACS_LLCORNER);
+    mvhline(y + height - 1, x + 1, ACS_HLINE, width - 2);
+    mvaddch(y + height - 1, x + width - 1, ACS_LRCORNER);
+}
+
+static void ncurses_refresh(void *ctx) {
+    (void)ctx;
+    refresh();
+}
+
+// DISPLAY_KEY_NONE for nothing (ERR) or some other special key we don't care about
+static int ncurses_translate_key(int ch) {
+    switch (ch) {
+        case KEY_LEFT:
+            return DISPLAY_KEY_LEFT;
+        case KEY_RIGHT:
+            return DISPLAY_KEY_RIGHT;
+        case KEY_UP:
+            return DISPLAY_KEY_UP;
+        case KEY_DOWN:
+            return DISPLAY_KEY_DOWN;
+        case KEY_RESIZE:
+            return DISPLAY_KEY_RESIZE;
+        default:
+            if (ch != ERR && ch < DISPLAY_KEY_LEFT) {
+                return ch;
+            }
+            return DISPLAY_KEY_NONE;
+    }
+}
+
+static int ncurses_get_key(void *ctx) {
+    (void)ctx;
+    for (;;) {
+        int key = ncurses_translate_key(getch()); // blocks until a key is pressed
+        if (key != DISPLAY_KEY_NONE) {
+            return key;
+        }
+    }
+}
+
+static int ncurses_poll_key(void *ctx, int timeout_ms) {
+    (void)ctx;
+    timeout(timeout_ms);
+    int key = ncurses_translate_key(getch());
+    timeout(-1); // back to blocking for get_key
+    return key;
+}
+
+static const struct DisplayBackendOps ncurses_ops = {
+    .destroy = ncurses_destroy,
+    .get_size = ncurses_get_size,
+    .erase = ncurses_erase,
+    .clear_rect = ncurses_clear_rect,
+    .put_cells = ncurses_put_cells,
+    .put_text = ncurses_put_text,
+    .draw_box = ncurses_draw_box,
+    .refresh = ncurses_refresh,
+    .get_key = ncurses_get_key,
+    .poll_key = ncurses_poll_key,
+};
+
+bool display_backend_ncurses_init(struct DisplayBackend *backend) {
+    // ncurses setup
+    initscr();
+    if (!has_colors()) {
+        endwin();
+        printf("smines requires color support in your terminal to work properly.\n");
+        return false;
+    }
+    keypad(stdscr, TRUE); // arrow keys
+    noecho(); // don't show letter on key press
+    curs_set(0); // make cursor invisible
+    nodelay(stdscr, 0); // block while waiting for key press
+    start_color();
+    use_default_colors(); // allows extra colors such as terminal background color
+
+    // set up color pairs
+    // init_pair(id, fg, bg);
+    init_pair(TILE_ZERO, COLOR_WHITE, COLOR_BLACK);
+    init_pair(TILE_MINE, COLOR_RED, COLOR_BLACK);
+    init_pair(TILE_MINE_SAFE, COLOR_GREEN, COLOR_BLACK);
+
+    init_pair(TILE_ONE, COLOR_WHITE, COLOR_BLUE);
+    init_pair(TILE_TWO, COLOR_BLACK, COLOR_GREEN);
+    init_pair(TILE_THREE, COLOR_WHITE, COLOR_RED);
+    init_pair(TILE_FOUR, COLOR_BLACK, COLOR_CYAN);
+    init_pair(TILE_FIVE, COLOR_WHITE, 94);
+    init_pair(TILE_SIX, COLOR_BLACK, COLOR_MAGENTA);
+    init_pair(TILE_SEVEN, COLOR_WHITE, COLOR_BLACK);
+    init_pair(TILE_EIGHT, COLOR_WHITE, COLOR_LIGHT_BLACK);
+
+    init_pair(TILE_HIDDEN, COLOR_LIGHT_BLACK, -1);
+    init_pair(TILE_FLAG, COLOR_YELLOW, COLOR_BLACK);
+    init_pair(TILE_FLAG_WRONG, COLOR_BLUE, COLOR_BLACK);
+    init_pair(TILE_CURSOR, COLOR_BLACK, COLOR_WHITE);
+
+    init_pair(TILE_ERROR, COLOR_WHITE, COLOR_RED);
+
+    init_pair(MSG_DEATH, COLOR_RED, -1);
+    init_pair(MSG_WIN, COLOR_GREEN, -1);
+
+    init_pair(HEAT_SAFE, COLOR_BLACK, COLOR_GREEN);
+    init_pair(HEAT_LOW, COLOR_BLACK, COLOR_CYAN);
+    init_pair(HEAT_MEDIUM, COLOR_BLACK, COLOR_YELLOW);
+    init_pair(HEAT_HIGH, COLOR_WHITE, COLOR_RED);
+    init_pair(HEAT_MINE, COLOR_WHITE, COLOR_MAGENTA);
+
+    struct NcursesBackend *ncurses_backend = calloc(1, sizeof(struct NcursesBackend));
+    if (!ncurses_backend) {
+        endwin();
+        return false;
+    }
+    backend->ops = &ncurses_ops;
+    backend->ctx = ncurses_backend;
+    return true;
+}
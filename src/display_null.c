@@ -0,0 +1,101 @@
+#include "display_backend.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct NullBackend {
+    int rows, cols;
+    const char *keys; // what's left of the key script
+};
+
+static void null_destroy(void *ctx) {
+    free(ctx);
+}
+
+static void null_get_size(void *ctx, int *rows, int *cols) {
+    struct NullBackend *null = ctx;
+    *rows = null->rows;
+    *cols = null->cols;
+}
+
+static void null_erase(void *ctx) {
+    (void)ctx;
+}
+
+static void null_clear_rect(void *ctx, int y, int x, int height, int width) {
+    (void)ctx;
+    (void)y;
+    (void)x;
+    (void)height;
+    (void)width;
+}
+
+static void null_put_cells(void *ctx, int y, int x, const struct Cell *cells, int n) {
+    (void)ctx;
+    (void)y;
+    (void)x;
+    (void)cells;
+    (void)n;
+}
+
+static void null_put_text(void *ctx, int y, int x, const char *text, uint8_t color, uint8_t attr) {
+    (void)ctx;
+    (void)y;
+    (void)x;
+    (void)text;
+    (void)color;
+    (void)attr;
+}
+
+static void null_draw_box(void *ctx, int y, int x, int height, int width) {
+    (void)ctx;
+    (void)y;
+    (void)x;
+    (void)height;
+    (void)width;
+}
+
+static void null_refresh(void *ctx) {
+    (void)ctx;
+}
+
+static int null_get_key(void *ctx) {
+    struct NullBackend *null = ctx;
+    if (!null->keys || *null->keys == '\0') {
+        return DISPLAY_KEY_EOF;
+    }
+    return (unsigned char)*null->keys++;
+}
+
+static int null_poll_key(void *ctx, int timeout_ms) {
+    (void)timeout_ms;
+    int key = null_get_key(ctx);
+    return key == DISPLAY_KEY_EOF ? DISPLAY_KEY_NONE : key;
+}
+
+static const struct DisplayBackendOps null_ops = {
+    .destroy = null_destroy,
+    .get_size = null_get_size,
+    .erase = null_erase,
+    .clear_rect = null_clear_rect,
+    .put_cells = null_put_cells,
+    .put_text = null_put_text,
+    .draw_box = null_draw_box,
+    .refresh = null_refresh,
+    .get_key = null_get_key,
+    .poll_key = null_poll_key,
+};
+
+bool display_backend_null_init(struct DisplayBackend *backend, int rows, int cols, const char *keys) {
+    struct NullBackend *null = malloc(sizeof(struct NullBackend));
+    if (!null) {
+        return false;
+    }
+    null->rows = rows;
+    null->cols = cols;
+    null->keys = keys;
+
+    backend->ops = &null_ops;
+    backend->ctx = null;
+    return true;
+}
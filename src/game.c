@@ -1,53 +1,190 @@
 #include "game.h"
 
+#include "journal.h"
 #include "minefield.h"
+#include "probability.h"
+#include "solver.h"
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
-void game_init(struct Game *game, size_t width, size_t height, size_t mines) {
+// everything about a new game except the board and the solver's tiles
+static void game_init_rest(struct Game *game, size_t undo_bytes, bool solver_ready) {
+    journal_clear(&game->journal);
+    game->journal.max_bytes = undo_bytes == SIZE_MAX ? 0 : undo_bytes;
+    // without a journal attached nothing gets recorded, so every move ends up empty and gets dropped
+    game->minefield.journal = undo_bytes ? &game->journal : NULL;
+    // hints just won't find anything without it
+    game->minefield.solver = solver_ready ? &game->solver : NULL;
+    probability_init(&game->probability, &game->minefield, &game->solver);
+    game->guesses = 0;
+}
+
+void game_init(struct Game *game, size_t width, size_t height, size_t mines, uint64_t seed, size_t undo_bytes) {
+    game->state = ALIVE;
+    minefield_init(&game->minefield, width, height, mines, seed);
+    game_init_rest(game, undo_bytes, solver_init(&game->solver, &game->minefield));
+}
+
+void game_init_swap(struct Game *game, struct Minefield *board, uint8_t **solver_tiles, size_t undo_bytes) {
     game->state = ALIVE;
-    minefield_init(&game->minefield, width, height, mines);
+    struct Minefield last = game->minefield;
+    game->minefield = *board;
+    *board = last;
+    // the old board isn't this game's anymore, nothing it does should end up in the journal or solver
+    board->journal = NULL;
+    board->solver = NULL;
+    *solver_tiles = solver_init_with_tiles(&game->solver, &game->minefield, *solver_tiles);
+    game_init_rest(game, undo_bytes, game->solver.tiles != NULL);
 }
 
 void game_cleanup(struct Game *game) {
     minefield_cleanup(&game->minefield);
+    journal_cleanup(&game->journal);
+    solver_cleanup(&game->solver);
+    probability_cleanup(&game->probability);
 }
 
-void game_click_tile(struct Game *game, size_t x, size_t y) {
-    game_undo_store(game);
-    bool still_alive = minefield_reveal_tile(&game->minefield, x, y); // false if dead from clicking a mine
+// update the game state after revealing a tile
+static void game_after_reveal(struct Game *game, bool still_alive) {
     if (!still_alive) {
         game->state = DEAD;
-        // reveal all the mines
-        for (size_t x = 0; x < game->minefield.width; x++) {
-            for (size_t y = 0; y < game->minefield.height; y++) {
-                if (minefield_get_tile(&game->minefield, x, y)->mine) {
-                    minefield_get_tile(&game->minefield, x, y)->visible = true;
-                }
-            }
-        }
+        minefield_reveal_mines(&game->minefield);
     } else if (minefield_check_victory(&game->minefield)) {
         game->state = VICTORY;
-        for (size_t x = 0; x < game->minefield.width; x++) {
-            for (size_t y = 0; y < game->minefield.height; y++) {
-                minefield_get_tile(&game->minefield, x, y)->visible = true;
-            }
-        }
-    } else {
-        // TODO: try recursion or someting here
+        minefield_reveal_all(&game->minefield);
     }
 }
 
-void game_undo_store(struct Game *game) {
-    game->undo.minefield = game->minefield;
-    game->undo.state = game->state;
+void game_click_tile(struct Game *game, size_t x, size_t y) {
+    journal_begin(&game->journal, game->minefield.cur.x, game->minefield.cur.y, game->state);
+    bool still_alive = minefield_reveal_tile(&game->minefield, x, y); // false if dead from clicking a mine
+    game_after_reveal(game, still_alive);
+    journal_end(&game->journal);
+}
+
+void game_toggle_flag(struct Game *game, size_t x, size_t y) {
+    journal_begin(&game->journal, game->minefield.cur.x, game->minefield.cur.y, game->state);
+    minefield_toggle_flag(&game->minefield, x, y);
+    journal_end(&game->journal);
+}
+
+// swap the cursor and game state stored in a move with the current ones
+static void game_swap_move_state(struct Game *game, struct JournalMove *move) {
+    int cur_x = game->minefield.cur.x;
+    int cur_y = game->minefield.cur.y;
+    int state = game->state;
+    minefield_set_cursor(&game->minefield, move->cur.x, move->cur.y);
+    game->state = move->state;
+    move->cur.x = cur_x;
+    move->cur.y = cur_y;
+    move->state = state;
+}
+
+bool game_undo(struct Game *game) {
+    struct Journal *journal = &game->journal;
+    if (journal->head == 0) {
+        return false;
+    }
+    journal->head--;
+    size_t start, end;
+    journal_move_entries(journal, journal->head, &start, &end);
+    // newest first, in case a tile changed more than once
+    for (size_t i = end; i > start; i--) {
+        JournalEntry *entry = &journal->entries[i - 1];
+        uint8_t bits = JOURNAL_ENTRY_BITS(*entry);
+        minefield_swap_tile_marks(&game->minefield, JOURNAL_ENTRY_OFFSET(*entry), &bits);
+        *entry = JOURNAL_ENTRY(JOURNAL_ENTRY_OFFSET(*entry), bits);
+    }
+    game_swap_move_state(game, &journal->moves[journal->head]);
+    return true;
 }
 
-void game_undo(struct Game *game) {
-    enum GameState state_temp = game->state;
-    struct Minefield minefield_temp = game->minefield;
-    game->state = game->undo.state;
-    game->minefield = game->undo.minefield;
-    game->undo.state = state_temp;
-    game->undo.minefield = minefield_temp;
+bool game_redo(struct Game *game) {
+    struct Journal *journal = &game->journal;
+    if (journal->head == journal->moves_len) {
+        return false;
+    }
+    size_t start, end;
+    journal_move_entries(journal, journal->head, &start, &end);
+    for (size_t i = start; i < end; i++) {
+        JournalEntry *entry = &journal->entries[i];
+        uint8_t bits = JOURNAL_ENTRY_BITS(*entry);
+        minefield_swap_tile_marks(&game->minefield, JOURNAL_ENTRY_OFFSET(*entry), &bits);
+        *entry = JOURNAL_ENTRY(JOURNAL_ENTRY_OFFSET(*entry), bits);
+    }
+    game_swap_move_state(game, &journal->moves[journal->head]);
+    journal->head++;
+    return true;
+}
+
+bool game_hint(struct Game *game, size_t *x, size_t *y) {
+    if (!game->minefield.solver) {
+        return false;
+    }
+    solver_solve(&game->solver);
+    return solver_next_safe(&game->solver, game->minefield.cur.x, game->minefield.cur.y, x, y);
+}
+
+bool game_update_probabilities(struct Game *game) {
+    if (!game->minefield.solver) {
+        return false;
+    }
+    return !probability_stale(&game->probability) || probability_compute(&game->probability);
+}
+
+size_t game_autoplay(struct Game *game, bool guess) {
+    if (!game->minefield.solver) {
+        return 0;
+    }
+    struct Minefield *minefield = &game->minefield;
+    struct Solver *solver = &game->solver;
+    size_t moves = 0;
+    journal_begin(&game->journal, minefield->cur.x, minefield->cur.y, game->state);
+    while (game->state == ALIVE) {
+        solver_solve(solver);
+        size_t before = moves;
+        for (size_t i = 0; i < solver->mines.len; i++) {
+            size_t offset = solver->mines.items[i];
+            size_t x = offset % minefield->width;
+            size_t y = offset / minefield->width;
+            if (!tile_is_flagged(minefield_get_tile(minefield, x, y))) {
+                minefield_toggle_flag(minefield, x, y);
+                moves++;
+            }
+        }
+        // safe tiles under a (wrong) flag are left alone, the player put it there
+        for (size_t i = 0; i < solver->safe.len && game->state == ALIVE;) {
+            size_t offset = solver->safe.items[i];
+            size_t x = offset % minefield->width;
+            size_t y = offset / minefield->width;
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (tile_is_flagged(tile)) {
+                i++;
+                continue;
+            }
+            if (!tile_is_visible(tile)) {
+                game_after_reveal(game, minefield_reveal_tile(minefield, x, y));
+                moves++;
+            }
+            // it's visible now either way, so it doesn't need to stay on the list
+            solver->safe.items[i] = solver->safe.items[--solver->safe.len];
+        }
+        if (moves == before && game->state == ALIVE) {
+            size_t x, y;
+            if (!guess || !game_update_probabilities(game) ||
+                !probability_best_guess(&game->probability, minefield->cur.x, minefield->cur.y, &x, &y)) {
+                break;
+            }
+            // enumerating can find safe tiles the solver can't, those aren't guesses
+            if (game->probability.tiles[y * minefield->width + x] > 0) {
+                game->guesses++;
+            }
+            game_after_reveal(game, minefield_reveal_tile(minefield, x, y));
+            moves++;
+        }
+    }
+    journal_end(&game->journal);
+    return moves;
 }
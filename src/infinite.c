@@ -0,0 +1,301 @@
+#include "infinite.h"
+
+#include "minefield.h"
+#include "rng.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define CHUNK_TILES (INFINITE_CHUNK_SIZE * INFINITE_CHUNK_SIZE)
+
+// which chunk a tile coordinate is in, rounding down for negative coordinates too
+static inline int64_t infinite_chunk_coord(int64_t tile) {
+    return tile >= 0 ? tile / INFINITE_CHUNK_SIZE : -((-(tile + 1)) / INFINITE_CHUNK_SIZE) - 1;
+}
+static inline size_t infinite_chunk_hash(int64_t x, int64_t y) {
+    uint64_t h = (uint64_t)x * 0x9e3779b97f4a7c15 ^ (uint64_t)y * 0xc2b2ae3d27d4eb4f;
+    return h ^ h >> 32;
+}
+
+bool infinite_init(struct InfiniteField *field, uint64_t seed, size_t chunk_mines) {
+    *field = (struct InfiniteField){0};
+    field->seed = seed;
+    field->chunk_mines = chunk_mines;
+    if (chunk_mines < INFINITE_MIN_CHUNK_MINES || chunk_mines > CHUNK_TILES) {
+        return false;
+    }
+    field->chunks.cap = 64;
+    field->chunks.items = calloc(field->chunks.cap, sizeof(struct InfiniteChunk *));
+    if (!field->chunks.items) {
+        return false;
+    }
+    return true;
+}
+
+void infinite_cleanup(struct InfiniteField *field) {
+    for (size_t i = 0; i < field->chunks.cap; i++) {
+        if (field->chunks.items[i]) {
+            free(field->chunks.items[i]->tiles);
+            free(field->chunks.items[i]);
+        }
+    }
+    free(field->chunks.items);
+    free(field->reveal_stack.items);
+    *field = (struct InfiniteField){0};
+}
+
+// the slot a chunk is in, or the empty slot it would go in
+static size_t infinite_chunk_slot(struct InfiniteField *field, int64_t x, int64_t y) {
+    size_t mask = field->chunks.cap - 1;
+    size_t slot = infinite_chunk_hash(x, y) & mask;
+    for (;;) {
+        struct InfiniteChunk *chunk = field->chunks.items[slot];
+        if (!chunk || (chunk->x == x && chunk->y == y)) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+// double the table once it's half full, so probes stay short. returns false if out of memory, the table
+// is left how it was then
+static bool infinite_chunks_grow(struct InfiniteField *field) {
+    if (field->chunks.len + 1 <= field->chunks.cap / 2) {
+        return true;
+    }
+    struct InfiniteChunk **items = calloc(field->chunks.cap * 2, sizeof(struct InfiniteChunk *));
+    if (!items) {
+        return false;
+    }
+    struct InfiniteChunk **old = field->chunks.items;
+    size_t old_cap = field->chunks.cap;
+    field->chunks.items = items;
+    field->chunks.cap *= 2;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i]) {
+            field->chunks.items[infinite_chunk_slot(field, old[i]->x, old[i]->y)] = old[i];
+        }
+    }
+    free(old);
+    return true;
+}
+
+// splitmix64's finalizer, on the value after `value` so that 0 doesn't stay 0
+static inline uint64_t infinite_mix(uint64_t value) {
+    uint64_t z = value + 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+// the rng_derive_seed index of a chunk. both coordinates go into one index: deriving once per coordinate
+// would give (0, k) and (k, 0) the same seed (rng_derive_seed hands index 0 back the seed unchanged),
+// so the board would repeat along both axes
+static inline uint64_t infinite_chunk_index(int64_t x, int64_t y) {
+    uint64_t mixed_y = infinite_mix((uint64_t)y);
+    return infinite_mix((uint64_t)x) ^ (mixed_y << 32 | mixed_y >> 32);
+}
+
+// put down the chunk's mines: Floyd's sampling like minefield_sample_mines, on one chunk's worth of tiles,
+// with an rng that only depends on the seed and where the chunk is
+static void infinite_chunk_populate(struct InfiniteField *field, struct InfiniteChunk *chunk) {
+    struct Rng rng;
+    rng_seed(&rng, rng_derive_seed(field->seed, infinite_chunk_index(chunk->x, chunk->y)));
+    for (size_t j = CHUNK_TILES - field->chunk_mines; j < CHUNK_TILES; j++) {
+        size_t i = rng_below(&rng, j + 1);
+        if (chunk->mines[i / INFINITE_CHUNK_SIZE] >> (i % INFINITE_CHUNK_SIZE) & 1) {
+            i = j;
+        }
+        chunk->mines[i / INFINITE_CHUNK_SIZE] |= (uint64_t)1 << (i % INFINITE_CHUNK_SIZE);
+    }
+    // the first click's 3x3 is kept clear
+    for (int64_t y = -1; y <= 1; y++) {
+        for (int64_t x = -1; x <= 1; x++) {
+            if (infinite_chunk_coord(x) == chunk->x && infinite_chunk_coord(y) == chunk->y) {
+                int64_t local_x = x - chunk->x * INFINITE_CHUNK_SIZE;
+                int64_t local_y = y - chunk->y * INFINITE_CHUNK_SIZE;
+                chunk->mines[local_y] &= ~((uint64_t)1 << local_x);
+            }
+        }
+    }
+}
+// get a chunk, making it (without tiles) if it doesn't exist yet; NULL if out of memory
+static struct InfiniteChunk *infinite_chunk(struct InfiniteField *field, int64_t x, int64_t y) {
+    if (field->last && field->last->x == x && field->last->y == y) {
+        return field->last;
+    }
+    size_t slot = infinite_chunk_slot(field, x, y);
+    struct InfiniteChunk *chunk = field->chunks.items[slot];
+    if (!chunk) {
+        chunk = infinite_chunks_grow(field) ? calloc(1, sizeof(struct InfiniteChunk)) : NULL;
+        if (!chunk) {
+            field->out_of_memory = true;
+            return NULL;
+        }
+        chunk->x = x;
+        chunk->y = y;
+        infinite_chunk_populate(field, chunk);
+        field->chunks.items[infinite_chunk_slot(field, x, y)] = chunk;
+        field->chunks.len++;
+    }
+    field->last = chunk;
+    return chunk;
+}
+
+// mines in the 3 tiles around bit x of a row (x - 1, x, x + 1), `left` and `right` are the tiles
+// just past either end of the row, from the chunks next to this one
+static inline uint8_t infinite_row_count(uint64_t row, bool left, bool right, int x) {
+    uint64_t window = x == 0 ? (row << 1 | left) & 7 : row >> (x - 1) & 7;
+    if (x == INFINITE_CHUNK_SIZE - 1) {
+        window |= (uint64_t)right << 2;
+    }
+    return __builtin_popcountll(window);
+}
+// allocate a chunk's tiles and work out their numbers, which needs the mines of all 8 chunks around it
+// returns false if out of memory
+static bool infinite_chunk_fill(struct InfiniteField *field, struct InfiniteChunk *chunk) {
+    struct InfiniteChunk *around[3][3];
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            around[dy + 1][dx + 1] = infinite_chunk(field, chunk->x + dx, chunk->y + dy);
+            if (!around[dy + 1][dx + 1]) {
+                return false;
+            }
+        }
+    }
+    // infinite_chunk might have moved field->last off this chunk, that's fine, it's only a hint
+    struct Tile *tiles = calloc(CHUNK_TILES, sizeof(struct Tile));
+    if (!tiles) {
+        field->out_of_memory = true;
+        return false;
+    }
+    const int last = INFINITE_CHUNK_SIZE - 1;
+    for (int y = 0; y < INFINITE_CHUNK_SIZE; y++) {
+        uint8_t counts[INFINITE_CHUNK_SIZE] = {0};
+        for (int dy = -1; dy <= 1; dy++) {
+            // the row dy away, and which row of chunks it's in
+            int row_y = y + dy;
+            int chunk_row = row_y < 0 ? 0 : row_y > last ? 2 : 1;
+            row_y = (row_y + INFINITE_CHUNK_SIZE) % INFINITE_CHUNK_SIZE;
+            uint64_t row = around[chunk_row][1]->mines[row_y];
+            bool left = around[chunk_row][0]->mines[row_y] >> last & 1;
+            bool right = around[chunk_row][2]->mines[row_y] & 1;
+            for (int x = 0; x < INFINITE_CHUNK_SIZE; x++) {
+                counts[x] += infinite_row_count(row, left, right, x);
+            }
+        }
+        uint64_t mines = chunk->mines[y];
+        for (int x = 0; x < INFINITE_CHUNK_SIZE; x++) {
+            tiles[y * INFINITE_CHUNK_SIZE + x].bits = counts[x] | (mines >> x & 1 ? TILE_MINE_BIT : 0);
+        }
+    }
+    chunk->tiles = tiles;
+    field->tile_chunks++;
+    return true;
+}
+
+struct Tile *infinite_get_tile(struct InfiniteField *field, int64_t x, int64_t y) {
+    struct InfiniteChunk *chunk = infinite_chunk(field, infinite_chunk_coord(x), infinite_chunk_coord(y));
+    if (!chunk) {
+        return NULL;
+    }
+    if (!chunk->tiles) {
+        if (!infinite_chunk_fill(field, chunk)) {
+            return NULL;
+        }
+        field->last = chunk;
+    }
+    size_t local_x = x - chunk->x * INFINITE_CHUNK_SIZE;
+    size_t local_y = y - chunk->y * INFINITE_CHUNK_SIZE;
+    return &chunk->tiles[local_y * INFINITE_CHUNK_SIZE + local_x];
+}
+
+// push an (x, y) pair on the reveal stack, returns false if out of memory
+static bool infinite_reveal_push(struct InfiniteField *field, size_t *len, int64_t x, int64_t y) {
+    if (*len == field->reveal_stack.cap) {
+        size_t cap = field->reveal_stack.cap ? field->reveal_stack.cap * 2 : 64;
+        int64_t *items = realloc(field->reveal_stack.items, cap * 2 * sizeof(int64_t));
+        if (!items) {
+            field->out_of_memory = true;
+            return false;
+        }
+        field->reveal_stack.items = items;
+        field->reveal_stack.cap = cap;
+    }
+    field->reveal_stack.items[2 * *len] = x;
+    field->reveal_stack.items[2 * *len + 1] = y;
+    (*len)++;
+    return true;
+}
+
+bool infinite_reveal_tile(struct InfiniteField *field, int64_t x, int64_t y) {
+    struct Tile *tile = infinite_get_tile(field, x, y);
+    if (!tile) {
+        return true;
+    }
+    assert(!tile_is_flagged(tile));
+    bool start_visible = tile_is_visible(tile);
+    if (tile_is_mine(tile)) {
+        return false;
+    }
+    if (!start_visible) {
+        tile->bits |= TILE_VISIBLE_BIT;
+        field->visible_tiles++;
+    }
+    if (tile_surrounding(tile) != 0 && !start_visible) {
+        return true;
+    }
+
+    // same as minefield_reveal_tile, except that there are no edges to stop at
+    bool no_mines = true;
+    size_t len = 0;
+    infinite_reveal_push(field, &len, x, y);
+    while (len > 0) {
+        len--;
+        x = field->reveal_stack.items[2 * len];
+        y = field->reveal_stack.items[2 * len + 1];
+        for (int64_t y1 = y - 1; y1 <= y + 1; y1++) {
+            for (int64_t x1 = x - 1; x1 <= x + 1; x1++) {
+                struct Tile *surtile = infinite_get_tile(field, x1, y1);
+                if (!surtile) {
+                    return no_mines; // out of memory, see infinite.out_of_memory
+                }
+                if (tile_is_visible(surtile) || tile_is_flagged(surtile)) {
+                    continue;
+                }
+                // only possible for the first tile, since zeroes can't have mines around them
+                if (tile_is_mine(surtile)) {
+                    no_mines = false;
+                    continue;
+                }
+                surtile->bits |= TILE_VISIBLE_BIT;
+                field->visible_tiles++;
+                if (tile_surrounding(surtile) == 0 && !infinite_reveal_push(field, &len, x1, y1)) {
+                    return no_mines;
+                }
+            }
+        }
+    }
+    return no_mines;
+}
+
+void infinite_toggle_flag(struct InfiniteField *field, int64_t x, int64_t y) {
+    struct Tile *tile = infinite_get_tile(field, x, y);
+    if (!tile || tile_is_visible(tile)) {
+        return;
+    }
+    tile->bits ^= TILE_FLAGGED_BIT;
+    if (tile_is_flagged(tile)) {
+        field->placed_flags++;
+    } else {
+        field->placed_flags--;
+    }
+}
+
+size_t infinite_memory(struct InfiniteField *field) {
+    return field->chunks.cap * sizeof(struct InfiniteChunk *)
+         + field->chunks.len * sizeof(struct InfiniteChunk)
+         + field->tile_chunks * CHUNK_TILES * sizeof(struct Tile)
+         + field->reveal_stack.cap * 2 * sizeof(int64_t);
+}
@@ -0,0 +1,119 @@
+#include "journal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void journal_init(struct Journal *journal, size_t max_bytes) {
+    *journal = (struct Journal){0};
+    journal->max_bytes = max_bytes;
+}
+
+void journal_cleanup(struct Journal *journal) {
+    free(journal->entries);
+    free(journal->moves);
+    journal_init(journal, journal->max_bytes);
+}
+
+void journal_clear(struct Journal *journal) {
+    journal->len = 0;
+    journal->moves_len = 0;
+    journal->head = 0;
+    journal->recording = false;
+}
+
+// make sure `count` more items fit, returns false if out of memory
+static bool journal_grow(void **items, size_t *cap, size_t len, size_t count, size_t size) {
+    if (len + count <= *cap) {
+        return true;
+    }
+    size_t new_cap = *cap ? *cap * 2 : 256;
+    while (new_cap < len + count) {
+        new_cap *= 2;
+    }
+    void *new_items = realloc(*items, new_cap * size);
+    if (!new_items) {
+        return false;
+    }
+    *items = new_items;
+    *cap = new_cap;
+    return true;
+}
+
+void journal_begin(struct Journal *journal, int cur_x, int cur_y, int state) {
+    journal->pending = (struct JournalMove){
+        .cur = { cur_x, cur_y },
+        .state = state,
+    };
+    journal->pending_added = false;
+    journal->recording = true;
+}
+
+// the move being recorded changed its first tile, so it's a real move now
+static bool journal_add_pending(struct Journal *journal) {
+    // a new move makes the redo history meaningless
+    if (journal->head < journal->moves_len) {
+        journal->len = journal->moves[journal->head].start;
+        journal->moves_len = journal->head;
+    }
+    if (!journal_grow((void **)&journal->moves, &journal->moves_cap, journal->moves_len, 1, sizeof(struct JournalMove))) {
+        return false;
+    }
+    journal->pending.start = journal->len;
+    journal->moves[journal->moves_len++] = journal->pending;
+    journal->head = journal->moves_len;
+    journal->pending_added = true;
+    return true;
+}
+
+void journal_record(struct Journal *journal, size_t offset, uint8_t bits) {
+    if ((!journal->pending_added && !journal_add_pending(journal))
+            || !journal_grow((void **)&journal->entries, &journal->cap, journal->len, 1, sizeof(JournalEntry))) {
+        // a move that's only partly recorded can't be undone, and neither can anything before it
+        journal_clear(journal);
+        return;
+    }
+    journal->entries[journal->len++] = JOURNAL_ENTRY(offset, bits);
+}
+
+// forget the oldest moves until the journal fits in max_bytes again
+// goes down to 3/4 of the limit, so the memmove isn't done again on the very next move
+static void journal_enforce_limit(struct Journal *journal) {
+    size_t bytes = journal->len * sizeof(JournalEntry) + journal->moves_len * sizeof(struct JournalMove);
+    if (journal->max_bytes == 0 || bytes <= journal->max_bytes) {
+        return;
+    }
+    size_t target = journal->max_bytes / 4 * 3;
+    size_t dropped = 0;
+    // always keep the latest move, even if it's bigger than the limit on its own
+    while (dropped + 1 < journal->moves_len && bytes > target) {
+        size_t start, end;
+        journal_move_entries(journal, dropped, &start, &end);
+        bytes -= (end - start) * sizeof(JournalEntry) + sizeof(struct JournalMove);
+        dropped++;
+    }
+    size_t first_entry = journal->moves[dropped].start;
+    memmove(journal->entries, journal->entries + first_entry, (journal->len - first_entry) * sizeof(JournalEntry));
+    memmove(journal->moves, journal->moves + dropped, (journal->moves_len - dropped) * sizeof(struct JournalMove));
+    journal->len -= first_entry;
+    journal->moves_len -= dropped;
+    journal->head -= dropped;
+    for (size_t i = 0; i < journal->moves_len; i++) {
+        journal->moves[i].start -= first_entry;
+    }
+}
+
+void journal_end(struct Journal *journal) {
+    if (!journal->recording) {
+        return; // out of memory since journal_begin, the history was dropped
+    }
+    journal->recording = false;
+    if (!journal->pending_added) {
+        return; // nothing happened, don't make undo skip over an empty move
+    }
+    journal_enforce_limit(journal);
+}
+
+void journal_move_entries(struct Journal *journal, size_t move, size_t *start, size_t *end) {
+    *start = journal->moves[move].start;
+    *end = move + 1 < journal->moves_len ? journal->moves[move + 1].start : journal->len;
+}
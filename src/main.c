@@ -1,15 +1,274 @@
+#include "difficulty.h"
 #include "display.h"
+#include "display_backend.h"
 #include "game.h"
+#include "infinite.h"
 #include "minefield.h"
+#include "pregen.h"
+#include "replay.h"
+#include "rng.h"
+#include "save.h"
 
 #include <getopt.h>
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <strings.h> // strcasecmp
+#include <string.h>
 #include <time.h>
 
+// the most a headless backend's screen grows to fit the board
+static const int HEADLESS_MAX_ROWS = 200;
+static const int HEADLESS_MAX_COLS = 400;
+// replay playback: time between events, and how far j/k jump
+static const int REPLAY_DELAY_MS = 100;
+static const int REPLAY_MAX_DELAY_MS = 2000;
+static const uint64_t REPLAY_JUMP = 100;
+// --infinite: mines per chunk unless --mines says otherwise (about the density of hard), and the board
+// size headless backends make room for
+static const size_t INFINITE_CHUNK_MINES = 820;
+static const int INFINITE_HEADLESS_WIDTH = 39;
+static const int INFINITE_HEADLESS_HEIGHT = 20;
+
+static bool open_backend(struct DisplayBackend *backend, const char *backend_name, const char *keys, int width, int height) {
+    // headless backends get a screen just big enough for the board, bigger boards scroll like on a terminal
+    int headless_rows = height + 8 < HEADLESS_MAX_ROWS ? height + 8 : HEADLESS_MAX_ROWS;
+    int headless_cols = width * 2 + 2 > 80 ? width * 2 + 2 : 80;
+    if (headless_cols > HEADLESS_MAX_COLS) {
+        headless_cols = HEADLESS_MAX_COLS;
+    }
+    if (strcmp(backend_name, "buffer") == 0) {
+        return display_backend_buffer_init(backend, headless_rows, headless_cols, keys);
+    } else if (strcmp(backend_name, "null") == 0) {
+        return display_backend_null_init(backend, headless_rows, headless_cols, keys);
+    } else {
+        return display_backend_ncurses_init(backend);
+    }
+}
+
+// --replay: show a recorded session instead of playing
+static int play_replay(const char *path, const char *backend_name, const char *keys) {
+    struct ReplayPlayer player;
+    if (!replay_player_open(&player, path)) {
+        printf("couldn't read replay from %s\n", path);
+        replay_player_close(&player);
+        return 1;
+    }
+    player.game.minefield.index_openings = true; // for the 3BV on the scoreboard
+    struct DisplayBackend backend;
+    if (!open_backend(&backend, backend_name, keys, player.header.width, player.header.height)) {
+        replay_player_close(&player);
+        return 1;
+    }
+    struct Display display;
+    display_init(&display, backend);
+    display.game_number = player.game_number;
+    display_set_game(&display, &player.game);
+
+    bool playing = true;
+    int delay_ms = REPLAY_DELAY_MS;
+    char status[64];
+    for (;;) {
+        snprintf(status, sizeof(status), "%s %" PRIu64 "/%" PRIu64, playing ? "Playing" : "Paused",
+                 player.event, player.events);
+        display.status = status;
+        display_draw(&display);
+        display_refresh(&display);
+        int ch = playing ? display_poll_key(&display, delay_ms) : display_get_key(&display);
+        if (ch == DISPLAY_KEY_EOF || ch == 'q') {
+            break;
+        }
+        uint32_t game_number = player.game_number;
+        bool seeked = false;
+        switch (ch) {
+            case DISPLAY_KEY_NONE: // time for the next event
+                playing = replay_player_step(&player);
+                break;
+            case DISPLAY_KEY_RESIZE:
+                display_resize(&display);
+                break;
+            case ' ': // pause/play
+                playing = !playing && player.event < player.events;
+                break;
+
+            // stepping pauses, jumping keeps playing
+            case 'l':
+            case DISPLAY_KEY_RIGHT:
+                playing = false;
+                replay_player_step(&player);
+                break;
+            case 'h':
+            case DISPLAY_KEY_LEFT:
+                playing = false;
+                if (player.event > 0) {
+                    replay_player_seek(&player, player.event - 1);
+                    seeked = true;
+                }
+                break;
+            case 'k':
+            case DISPLAY_KEY_UP:
+                replay_player_seek(&player, player.event + REPLAY_JUMP);
+                seeked = true;
+                break;
+            case 'j':
+            case DISPLAY_KEY_DOWN:
+                replay_player_seek(&player, player.event > REPLAY_JUMP ? player.event - REPLAY_JUMP : 0);
+                seeked = true;
+                break;
+            case '0':
+            case '^':
+            case 'g':
+                replay_player_seek(&player, 0);
+                seeked = true;
+                break;
+            case '$':
+            case 'G':
+                replay_player_seek(&player, player.events);
+                seeked = true;
+                break;
+
+            case '+': // faster
+                delay_ms = delay_ms > 1 ? delay_ms / 2 : 1;
+                break;
+            case '-': // slower
+                delay_ms = delay_ms * 2 < REPLAY_MAX_DELAY_MS ? delay_ms * 2 : REPLAY_MAX_DELAY_MS;
+                break;
+        }
+        // seeking starts the game over from a snapshot, so everything gets drawn again
+        if (seeked || player.game_number != game_number) {
+            display.game_number = player.game_number;
+            display_set_game(&display, &player.game);
+        }
+    }
+
+    if (strcmp(backend_name, "buffer") == 0) {
+        display_backend_buffer_dump(&display.backend, stdout);
+    }
+    display_destroy(&display);
+    replay_player_close(&player);
+    return 0;
+}
+
+// --infinite: play on an endless board instead. there's no solver, undo, saving or recording for it,
+// only moving, revealing, flagging and starting over
+static int play_infinite(uint64_t seed, size_t chunk_mines, const char *backend_name, const char *keys) {
+    struct InfiniteField field;
+    if (!infinite_init(&field, seed, chunk_mines)) {
+        printf("couldn't make the infinite board\n");
+        infinite_cleanup(&field);
+        return 1;
+    }
+    struct DisplayBackend backend;
+    if (!open_backend(&backend, backend_name, keys, INFINITE_HEADLESS_WIDTH, INFINITE_HEADLESS_HEIGHT)) {
+        infinite_cleanup(&field);
+        return 1;
+    }
+    struct Display display;
+    display_init(&display, backend);
+    // same as the game loop in main: the first board uses the seed as-is, the ones after are drawn from it
+    struct Rng seeds;
+    rng_seed(&seeds, seed);
+    enum GameState state = ALIVE;
+    bool first_reveal = true;
+    display.game_number = 1;
+    display_set_infinite(&display, &field, &state);
+
+    int status = 0;
+    for (;;) {
+        display.status = field.out_of_memory ? "Out of memory" : NULL;
+        display_draw(&display);
+        display_refresh(&display);
+        int ch = display_get_key(&display);
+        if (ch == DISPLAY_KEY_EOF) {
+            break;
+        }
+        if (ch == DISPLAY_KEY_RESIZE) {
+            display_resize(&display);
+            continue;
+        }
+        if (display.state == HELP) {
+            if (ch == 'H' || ch == '?' || ch == 'q') {
+                display_transition_game(&display);
+            }
+            continue;
+        }
+        if (ch == 'q') {
+            break;
+        }
+        switch (ch) {
+            case 'L': // redraw screen
+                display_resize(&display);
+                break;
+            case 'r': // new board
+                infinite_cleanup(&field);
+                if (!infinite_init(&field, rng_next(&seeds), chunk_mines)) {
+                    status = 1;
+                    goto done;
+                }
+                state = ALIVE;
+                first_reveal = true;
+                display.game_number++;
+                display_set_infinite(&display, &field, &state);
+                break;
+            case 'H':
+            case '?':
+                display_transition_help(&display);
+                break;
+
+            // there are no edges, so nothing stops the cursor
+            case 'h':
+            case DISPLAY_KEY_LEFT:
+                field.cur.x--;
+                break;
+            case 'j':
+            case DISPLAY_KEY_DOWN:
+                field.cur.y++;
+                break;
+            case 'k':
+            case DISPLAY_KEY_UP:
+                field.cur.y--;
+                break;
+            case 'l':
+            case DISPLAY_KEY_RIGHT:
+                field.cur.x++;
+                break;
+
+            case ' ': { // reveal tile
+                if (state != ALIVE) {
+                    break;
+                }
+                if (first_reveal) {
+                    // only (0, 0), where the cursor starts, is sure to be safe
+                    field.cur.x = field.cur.y = 0;
+                    first_reveal = false;
+                }
+                struct Tile *tile = infinite_get_tile(&field, field.cur.x, field.cur.y);
+                if (tile && !tile_is_flagged(tile) && !infinite_reveal_tile(&field, field.cur.x, field.cur.y)) {
+                    state = DEAD;
+                }
+                break;
+            }
+            case 'f': // toggle flag
+                if (state == ALIVE) {
+                    infinite_toggle_flag(&field, field.cur.x, field.cur.y);
+                }
+                break;
+        }
+    }
+
+done:
+    if (strcmp(backend_name, "buffer") == 0) {
+        display_backend_buffer_dump(&display.backend, stdout);
+    }
+    display_destroy(&display);
+    if (status != 0) {
+        printf("couldn't make the infinite board\n");
+    }
+    infinite_cleanup(&field);
+    return status;
+}
+
 int main(int argc, char *argv[]) {
     // https://stackoverflow.com/questions/38462701/why-declare-a-static-variable-in-main
     static const char cmd_usage[] =
@@ -22,7 +281,29 @@ int main(int argc, char *argv[]) {
         "  -r, --rows=HEIGHT                Set the height of the minefield\n"
         "  -m, --mines=MINES                Set the amount of mines in the minefield\n"
         "  -d, --difficulty=DIFFICULTY      Set the rows, columns, and mines based on difficulty level\n"
-        "  -u, --allow-undo                 Allow undoing the last move\n"
+        "  -u, --allow-undo                 Allow undoing and redoing moves\n"
+        "  -g, --no-guess                   Only give boards that can be solved from the first click without guessing\n"
+        "  -b, --backend=BACKEND            Where to draw: ncurses (default), buffer or null\n"
+        "  -k, --keys=KEYS                  Keys to play with the buffer and null backends, quits after the last one\n"
+        "  -M, --undo-memory=MIB            Memory for the undo history, oldest moves are forgotten past this (default 64)\n"
+        "  -s, --seed=SEED                  Seed for the first board, later boards are derived from it\n"
+        "  -j, --threads=THREADS            Threads to reveal huge openings with (default 1)\n"
+        "  -o, --record=FILE                Write a replay of the session to FILE\n"
+        "  -R, --replay=FILE                Play back a replay instead of playing (size options aren't needed)\n"
+        "  -S, --save=FILE                  Save the game to FILE when quitting with q\n"
+        "  -L, --load=FILE                  Pick up a game saved with --save (size options aren't needed)\n"
+        "  -I, --infinite                   Play on an endless board; --mines is then per 64x64 chunk (default 820)\n"
+        "Backends:\n"
+        "  ncurses                  the terminal\n"
+        "  buffer                   draw into memory, print the final screen when done\n"
+        "  null                     don't draw anything, only run the game logic\n"
+        "Replay keys:\n"
+        "  space                    pause/play\n"
+        "  h/l, left/right          step back/forward one move\n"
+        "  j/k, down/up             jump back/forward 100 moves\n"
+        "  0/$, g/G                 go to the start/end\n"
+        "  +/-                      play faster/slower\n"
+        "  q                        quit\n"
         "Difficulties:\n"
         "  super-easy, super_easy   20x10, 10 mines\n"
         "  easy                     9x9,   10 mines\n"
@@ -32,6 +313,8 @@ int main(int argc, char *argv[]) {
 
     static int help_flag = 0;
     static int undo_flag = 0;
+    static int no_guess_flag = 0;
+    static int infinite_flag = 0;
     static const struct option long_options[] = {
         { "help",       no_argument,        &help_flag, 1   },
         { "cols",       required_argument,  0,          'r' },
@@ -39,6 +322,17 @@ int main(int argc, char *argv[]) {
         { "mines",      required_argument,  0,          'm' },
         { "difficulty", required_argument,  0,          'd' },
         { "allow-undo", no_argument,        &undo_flag, 1   },
+        { "no-guess",   no_argument,        &no_guess_flag, 1 },
+        { "seed",       required_argument,  0,          's' },
+        { "undo-memory", required_argument, 0,          'M' },
+        { "backend",    required_argument,  0,          'b' },
+        { "keys",       required_argument,  0,          'k' },
+        { "threads",    required_argument,  0,          'j' },
+        { "record",     required_argument,  0,          'o' },
+        { "replay",     required_argument,  0,          'R' },
+        { "save",       required_argument,  0,          'S' },
+        { "load",       required_argument,  0,          'L' },
+        { "infinite",   no_argument,        &infinite_flag, 1 },
         { 0, 0, 0, 0 }
     };
     // TODO: make these unsigned and also use stdint
@@ -46,12 +340,21 @@ int main(int argc, char *argv[]) {
     int width = -1;
     int height = -1;
     int mines = -1;
+    uint64_t seed = (uint64_t)time(NULL);
+    size_t undo_mib = 64;
+    const char *backend_name = "ncurses";
+    const char *keys = NULL;
+    int reveal_threads = 1;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *save_path = NULL;
+    const char *load_path = NULL;
 
     bool exit_for_invalid_args = false;
     int opt_idx = 0;
     char *strtol_endptr;
     int c;
-    while ((c = getopt_long(argc, argv, "hc:r:m:d:u", long_options, &opt_idx)) != -1) {
+    while ((c = getopt_long(argc, argv, "hc:r:m:d:ugs:M:b:k:j:o:R:S:L:I", long_options, &opt_idx)) != -1) {
         switch (c) {
             case 0:
                 // do nothing else if flag was set
@@ -102,31 +405,73 @@ int main(int argc, char *argv[]) {
                     exit_for_invalid_args = true;
                 }
                 break;
-            case 'd':
-                if (strcasecmp(optarg, "easy") == 0) {
-                    width = 9;
-                    height = 9;
-                    mines = 10;
-                } else if (strcasecmp(optarg, "super-easy") == 0 || strcasecmp(optarg, "super_easy") == 0) {
-                    width = 20;
-                    height = 10;
-                    mines = 10;
-                } else if (strcasecmp(optarg, "intermediate") == 0 || strcasecmp(optarg, "medium") == 0) {
-                    width = 16;
-                    height = 16;
-                    mines = 40;
-                } else if (strcasecmp(optarg, "hard") == 0) {
-                    width = 30;
-                    height = 16;
-                    mines = 99;
-                } else {
+            case 'd': {
+                const struct Difficulty *difficulty = difficulty_find(optarg);
+                if (!difficulty) {
                     printf("invalid difficulty: %s\n", optarg);
                     exit_for_invalid_args = true;
+                    break;
                 }
+                width = difficulty->width;
+                height = difficulty->height;
+                mines = difficulty->mines;
                 break;
+            }
             case 'u':
                 undo_flag = 1;
                 break;
+            case 'g':
+                no_guess_flag = 1;
+                break;
+            case 'b':
+                if (strcmp(optarg, "ncurses") != 0 && strcmp(optarg, "buffer") != 0 && strcmp(optarg, "null") != 0) {
+                    printf("invalid backend: %s\n", optarg);
+                    exit_for_invalid_args = true;
+                }
+                backend_name = optarg;
+                break;
+            case 'k':
+                keys = optarg;
+                break;
+            case 'M':
+                errno = 0;
+                undo_mib = strtoull(optarg, &strtol_endptr, 10);
+                if (optarg == strtol_endptr || *strtol_endptr != '\0' || errno != 0) {
+                    printf("error parsing 'undo-memory' as number\n");
+                    exit_for_invalid_args = true;
+                }
+                break;
+            case 'j':
+                errno = 0;
+                reveal_threads = strtol(optarg, &strtol_endptr, 10);
+                if (optarg == strtol_endptr || *strtol_endptr != '\0' || errno != 0 || reveal_threads < 1) {
+                    printf("'threads' must be a positive number\n");
+                    exit_for_invalid_args = true;
+                }
+                break;
+            case 'o':
+                record_path = optarg;
+                break;
+            case 'R':
+                replay_path = optarg;
+                break;
+            case 'S':
+                save_path = optarg;
+                break;
+            case 'L':
+                load_path = optarg;
+                break;
+            case 'I':
+                infinite_flag = 1;
+                break;
+            case 's':
+                errno = 0;
+                seed = strtoull(optarg, &strtol_endptr, 10);
+                if (optarg == strtol_endptr || *strtol_endptr != '\0' || errno != 0) {
+                    printf("error parsing 'seed' as number\n");
+                    exit_for_invalid_args = true;
+                }
+                break;
             default:
                 abort();
         }
@@ -137,15 +482,20 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
-    if (width == -1) {
+    // replays and saved games have their own board size, the infinite board doesn't have one
+    bool sized = replay_path || load_path || infinite_flag;
+    if (infinite_flag && mines == -1) {
+        mines = INFINITE_CHUNK_MINES;
+    }
+    if (width == -1 && !sized) {
         printf("'width' was not set, use --width or --difficulty\n");
         exit_for_invalid_args = true;
     }
-    if (height == -1) {
+    if (height == -1 && !sized) {
         printf("'height' was not set, use --height or --difficulty\n");
         exit_for_invalid_args = true;
     }
-    if (mines == -1) {
+    if (mines == -1 && !sized) {
         printf("'mines' was not set, use --mines or --difficulty\n");
         exit_for_invalid_args = true;
     }
@@ -164,46 +514,124 @@ int main(int argc, char *argv[]) {
         putchar('\n');
     }
 
-    if (mines > (width * height) - 9) { // subtract 9 because mines can't be around the start
+    if (replay_path) {
+        return play_replay(replay_path, backend_name, keys);
+    }
+    if (infinite_flag) {
+        if (record_path || save_path || load_path || undo_flag || no_guess_flag) {
+            printf("--infinite can't be used with --record, --save, --load, --allow-undo or --no-guess\n");
+            return 1;
+        }
+        if (mines < INFINITE_MIN_CHUNK_MINES || mines > INFINITE_CHUNK_SIZE * INFINITE_CHUNK_SIZE) {
+            printf("with --infinite, 'mines' is per chunk and must be from %d to %d\n", INFINITE_MIN_CHUNK_MINES,
+                   INFINITE_CHUNK_SIZE * INFINITE_CHUNK_SIZE);
+            return 1;
+        }
+        return play_infinite(seed, mines, backend_name, keys);
+    }
+
+    if (load_path && record_path) {
+        // replays rebuild every board from its seed, which a game that was already going can't be
+        printf("a loaded game can't be recorded\n");
+        return 1;
+    }
+    if (!load_path && mines > (width * height) - 9) { // subtract 9 because mines can't be around the start
         printf("minefield is not large enough to fit the requested amount of mines\n");
         return 1;
     }
-    if (width < 5) {
+    if (!load_path && width < 5) {
         printf("'width' must be at least 5\n");
         return 1;
     }
-    if (height < 5) {
+    if (!load_path && height < 5) {
         printf("'height' must be at least 5\n");
         return 1;
     }
 
-    srand((unsigned)time(NULL)); // seed the random number generator
+    // the first game uses the seed as-is so it can be passed back in with --seed,
+    // after that every game gets its own seed (shown on the scoreboard) drawn from this
+    struct Rng seeds;
+    rng_seed(&seeds, seed);
 
-    struct Display display;
     struct Game game = {0};
-    display_init(&display);
-    nodelay(stdscr, 0); // block while waiting for key press
+    game.minefield.reveal_threads = reveal_threads;
+    game.minefield.index_openings = true; // for the 3BV on the scoreboard
+    size_t undo_bytes = undo_flag ? undo_mib * 1024 * 1024 : 0;
+    // before the backend, so the errors aren't hidden by ncurses
+    if (load_path) {
+        if (!save_load(&game, load_path, undo_bytes)) {
+            printf("couldn't load a saved game from %s\n", load_path);
+            return 1;
+        }
+        // restarting plays on a board like the saved one
+        width = game.minefield.width;
+        height = game.minefield.height;
+        mines = game.minefield.mines;
+    }
+    struct ReplayWriter replay;
+    bool recording = false;
+    if (record_path) {
+        struct ReplayHeader header = { width, height, mines, seed, no_guess_flag };
+        if (!replay_writer_open(&replay, record_path, &header, &game)) {
+            printf("couldn't open %s to write the replay to\n", record_path);
+            return 1;
+        }
+        recording = true;
+    }
+
+    struct DisplayBackend backend;
+    if (!open_backend(&backend, backend_name, keys, width, height)) {
+        return 1;
+    }
 
+    struct Display display;
+    display_init(&display, backend);
+
+    // the next game's board gets made while this one is played, so restarting is instant
+    struct Pregen pregen;
     bool restart_game = true;
+    bool save_failed = false;
     while (restart_game) {
         display.game_number++;
-        game_init(&game, width, height, mines);
-        display_set_game(&display, &game); // TODO: why can't this just be run once at declaration above
-
+        // a loaded game is the first game; it had its first click already unless nothing is showing yet
         bool first_reveal = true;
+        if (load_path && display.game_number == 1) {
+            first_reveal = game.minefield.visible_tiles == 0;
+        } else if (display.game_number == 1) {
+            game_init(&game, width, height, mines, seed, undo_bytes);
+        } else {
+            pregen_next_game(&pregen, &game, seed, undo_bytes);
+        }
+        if (display.game_number == 1) {
+            // boards just don't get made ahead if this fails
+            pregen_init(&pregen, &game, no_guess_flag);
+        }
+        seed = rng_next(&seeds);
+        pregen_prepare(&pregen, seed);
+        display_set_game(&display, &game); // TODO: why can't this just be run once at declaration above
+        if (recording && display.game_number > 1) {
+            replay_write_new_game(&replay, game.minefield.seed);
+        }
 
         struct Tile *cur_tile = NULL; // pointer to the tile the cursor is on
         int ch; // key that was pressed
         bool continue_running_game = true;
         while (continue_running_game) {
+            if (display.heatmap && game.state == ALIVE && !first_reveal) {
+                game_update_probabilities(&game);
+            }
             display_draw(&display);
             display_refresh(&display);
             cur_tile = minefield_get_tile(&game.minefield, game.minefield.cur.x, game.minefield.cur.y);
-            ch = getch(); // blocks until a key is pressed
-            if (ch == KEY_RESIZE) {
+            ch = display_get_key(&display); // blocks until a key is pressed
+            if (ch == DISPLAY_KEY_RESIZE) {
                 display_resize(&display);
                 continue;
             }
+            if (ch == DISPLAY_KEY_EOF) { // ran out of scripted keys
+                restart_game = false;
+                break;
+            }
 
             if (display.state == HELP) {
                 switch (ch) {
@@ -223,6 +651,9 @@ int main(int argc, char *argv[]) {
                     break;
 
                 case 'q': // quit
+                    if (save_path && !save_write(&game, save_path)) {
+                        save_failed = true;
+                    }
                     restart_game = false;
                     continue_running_game = false;
                     break;
@@ -238,60 +669,93 @@ int main(int argc, char *argv[]) {
 
                 // movement keys
                 case 'h':
-                case KEY_LEFT:
+                case DISPLAY_KEY_LEFT:
                     if (game.minefield.cur.x > 0)
-                        game.minefield.cur.x--;
+                        minefield_set_cursor(&game.minefield, game.minefield.cur.x - 1, game.minefield.cur.y);
                     break;
                 case 'j':
-                case KEY_DOWN:
-                    if (game.minefield.cur.y < game.minefield.height - 1)
-                        game.minefield.cur.y++;
+                case DISPLAY_KEY_DOWN:
+                    if (game.minefield.cur.y < (int)game.minefield.height - 1)
+                        minefield_set_cursor(&game.minefield, game.minefield.cur.x, game.minefield.cur.y + 1);
                     break;
                 case 'k':
-                case KEY_UP:
+                case DISPLAY_KEY_UP:
                     if (game.minefield.cur.y > 0)
-                        game.minefield.cur.y--;
+                        minefield_set_cursor(&game.minefield, game.minefield.cur.x, game.minefield.cur.y - 1);
                     break;
                 case 'l':
-                case KEY_RIGHT:
-                    if (game.minefield.cur.x < game.minefield.width - 1)
-                        game.minefield.cur.x++;
+                case DISPLAY_KEY_RIGHT:
+                    if (game.minefield.cur.x < (int)game.minefield.width - 1)
+                        minefield_set_cursor(&game.minefield, game.minefield.cur.x + 1, game.minefield.cur.y);
                     break;
 
                 case '0':
                 case '^':
-                    game.minefield.cur.x = 0;
+                    minefield_set_cursor(&game.minefield, 0, game.minefield.cur.y);
                     break;
                 case '$':
-                    game.minefield.cur.x = game.minefield.width - 1;
+                    minefield_set_cursor(&game.minefield, game.minefield.width - 1, game.minefield.cur.y);
                     break;
                 case 'g':
-                    game.minefield.cur.y = 0;
+                    minefield_set_cursor(&game.minefield, game.minefield.cur.x, 0);
                     break;
                 case 'G':
-                    game.minefield.cur.y = game.minefield.height - 1;
+                    minefield_set_cursor(&game.minefield, game.minefield.cur.x, game.minefield.height - 1);
                     break;
 
                 case 'u': // undo
-                    if (undo_flag) {
-                        game_undo(&game);
+                    if (undo_flag && game_undo(&game) && recording) {
+                        replay_write_tiles(&replay, game.journal.head);
+                    }
+                    break;
+                case 'U': // redo
+                    if (undo_flag && game_redo(&game) && recording) {
+                        replay_write_tiles(&replay, game.journal.head - 1);
                     }
                     break;
 
+                case 'n': { // jump to a safe tile
+                    size_t x, y;
+                    if (game.state == ALIVE && game_hint(&game, &x, &y)) {
+                        minefield_set_cursor(&game.minefield, x, y);
+                    }
+                    break;
+                }
+                case 'a': // play every certain move
+                case 'A': // play until the game is over
+                    if (game.state == ALIVE && !first_reveal) {
+                        game_autoplay(&game, ch == 'A');
+                        if (recording) {
+                            replay_write_autoplay(&replay);
+                        }
+                    }
+                    break;
+                case 'p': // probability heatmap
+                    display_toggle_heatmap(&display);
+                    break;
+
                 case ' ': // reveal tile
                     if (first_reveal) {
+                        if (tile_is_flagged(cur_tile)) {
+                            break;
+                        }
                         // TODO: add these back lmao
-                        minefield_populate(&game.minefield);
+                        pregen_populate(&pregen, &game);
                         minefield_reveal_tile(&game.minefield, game.minefield.cur.x, game.minefield.cur.y);
                         first_reveal = false;
-                        game_undo_store(&game);
+                        if (recording) {
+                            replay_write_action(&replay, REPLAY_REVEAL);
+                        }
                         break;
                     }
                     if (game.state != ALIVE) {
                         break;
                     }
-                    if (!cur_tile->flagged) {
+                    if (!tile_is_flagged(cur_tile)) {
                         game_click_tile(&game, game.minefield.cur.x, game.minefield.cur.y);
+                        if (recording) {
+                            replay_write_action(&replay, REPLAY_REVEAL);
+                        }
                         break;
                     }
                     break;
@@ -300,21 +764,32 @@ int main(int argc, char *argv[]) {
                     if (game.state != ALIVE) {
                         break;
                     }
-                    if (!cur_tile->visible) {
-                        cur_tile->flagged = !cur_tile->flagged;
-                        if (cur_tile->flagged) {
-                            game.minefield.placed_flags++;
-                        } else {
-                            game.minefield.placed_flags--;
-                        }
+                    game_toggle_flag(&game, game.minefield.cur.x, game.minefield.cur.y);
+                    if (recording) {
+                        replay_write_action(&replay, REPLAY_FLAG);
                     }
                     break;
             }
+            if (recording) {
+                replay_write_cursor(&replay, game.minefield.cur.x, game.minefield.cur.y);
+            }
         }
     }
 
+    if (strcmp(backend_name, "buffer") == 0) {
+        display_backend_buffer_dump(&display.backend, stdout);
+    }
+    pregen_cleanup(&pregen);
     game_cleanup(&game);
     display_destroy(&display);
+    if (recording && !replay_writer_close(&replay)) {
+        printf("couldn't write the whole replay to %s\n", record_path);
+        return 1;
+    }
+    if (save_failed) {
+        printf("couldn't save the game to %s\n", save_path);
+        return 1;
+    }
 
     return 0;
 }
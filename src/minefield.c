@@ -1,23 +1,118 @@
+#define _POSIX_C_SOURCE 200809L // sched_yield, munmap
+
 #include "minefield.h"
 
+#include "journal.h"
+#include "rng.h"
+#include "solver.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
 #include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// boards at least this big, with at least 1 mine per this many tiles, are populated through a bitplane
+// (see minefield_populate); tuned with smines-bench
+#ifndef POPULATE_PLANE_MIN_TILES
+#define POPULATE_PLANE_MIN_TILES 4096
+#endif
+#ifndef POPULATE_PLANE_MIN_DENSITY
+#define POPULATE_PLANE_MIN_DENSITY 8
+#endif
+// flood fills still going after this many tiles are finished on minefield.reveal_threads threads
+#ifndef PARALLEL_REVEAL_MIN_TILES
+#define PARALLEL_REVEAL_MIN_TILES 65536
+#endif
+// tiles minefield.reveal_stack starts with room for
+#define REVEAL_STACK_MIN 64
+
+// tiles are only ever changed from in here, so that the counters stay correct
+static inline void tile_set_mine(struct Tile *tile) {
+    tile->bits |= TILE_MINE_BIT;
+}
+static inline void tile_set_visible(struct Tile *tile) {
+    tile->bits |= TILE_VISIBLE_BIT;
+}
+static inline void tile_toggle_flagged(struct Tile *tile) {
+    tile->bits ^= TILE_FLAGGED_BIT;
+}
+static inline void tile_add_surrounding(struct Tile *tile) {
+    // at most 9, so this never carries out of the low nibble
+    tile->bits++;
+}
+
+static void minefield_free_openings(struct Minefield *minefield) {
+    free(minefield->openings.ids);
+    free(minefield->openings.start);
+    free(minefield->openings.tiles);
+    minefield->openings.ids = NULL;
+    minefield->openings.start = NULL;
+    minefield->openings.tiles = NULL;
+    minefield->openings.built = false;
+    minefield->openings.count = 0;
+}
 
-bool minefield_init(struct Minefield *minefield, size_t width, size_t height, size_t mines) {
+static void minefield_free_tiles(struct Minefield *minefield) {
+    if (minefield->tiles_map.addr) {
+        munmap(minefield->tiles_map.addr, minefield->tiles_map.len);
+        minefield->tiles_map.addr = NULL;
+        minefield->tiles_map.len = 0;
+    } else {
+        free(minefield->tiles);
+    }
+    minefield->tiles = NULL;
+}
+
+bool minefield_init(struct Minefield *minefield, size_t width, size_t height, size_t mines, uint64_t seed) {
+    size_t old_tiles_len = minefield->tiles ? minefield_tiles_len(minefield) : 0;
     minefield->width = width;
     minefield->height = height;
     minefield->mines = mines;
+    minefield->seed = seed;
     minefield->placed_flags = 0;
+    minefield->visible_tiles = 0;
+    minefield->correct_flags = 0;
 
     minefield->cur.x = width / 2;
     minefield->cur.y = height / 2;
 
-    if (minefield->tiles != NULL) {
-        free(minefield->tiles);
+    minefield_free_openings(minefield);
+
+    // the tiles are brand new, so nothing is listed and everything needs drawing
+    minefield->dirty.len = 0;
+    minefield->dirty.all = true;
+
+    // reveals grow the stack as they go. it always has room for a few tiles, so a reveal can still make
+    // progress when growing it fails (see minefield_reveal_rescan)
+    if (!minefield->reveal_stack.items) {
+        minefield->reveal_stack.items = malloc(REVEAL_STACK_MIN * sizeof(size_t));
+        if (!minefield->reveal_stack.items) {
+            return false;
+        }
+        minefield->reveal_stack.cap = REVEAL_STACK_MIN;
     }
 
-    minefield->tiles = calloc(width * height, sizeof(struct Tile));
+    if (minefield->block_shift) {
+        size_t block = (size_t)1 << minefield->block_shift;
+        minefield->blocks_wide = (width + block - 1) / block;
+    }
+    // a new game on a board the same size just clears the last one's tiles instead of freeing them and
+    // getting a fresh (page faulting) allocation back
+    if (old_tiles_len && old_tiles_len == minefield_tiles_len(minefield) && !minefield->tiles_map.addr) {
+        memset(minefield->tiles, 0, old_tiles_len * sizeof(struct Tile));
+        return true;
+    }
+    minefield_free_tiles(minefield);
+    minefield->tiles = calloc(minefield_tiles_len(minefield), sizeof(struct Tile));
     if (!minefield->tiles) {
         return false;
     }
@@ -26,13 +121,83 @@ bool minefield_init(struct Minefield *minefield, size_t width, size_t height, si
 }
 
 void minefield_cleanup(struct Minefield *minefield) {
-    free(minefield->tiles);
+    minefield_free_tiles(minefield);
+    minefield_free_openings(minefield);
+    free(minefield->reveal_stack.items);
+    minefield->reveal_stack.items = NULL;
+    minefield->reveal_stack.cap = 0;
+    free(minefield->dirty.items);
+    minefield->dirty.items = NULL;
+    minefield->dirty.len = 0;
+    minefield->dirty.cap = 0;
+}
+
+// call right before changing a tile, so the move can be undone
+static inline void minefield_record_change(struct Minefield *minefield, size_t x, size_t y, struct Tile *tile) {
+    if (minefield->journal && minefield->journal->recording) {
+        journal_record(minefield->journal, y * minefield->width + x, tile->bits & ~TILE_DIRTY_BIT);
+    }
+}
+
+// call right after making a tile visible
+static inline void minefield_notify_revealed(struct Minefield *minefield, size_t x, size_t y) {
+    if (minefield->solver) {
+        solver_tile_revealed(minefield->solver, y * minefield->width + x);
+    }
+}
+
+// past this many dirty tiles, redrawing everything is about as cheap as going through the list
+static size_t minefield_dirty_limit(struct Minefield *minefield) {
+    return minefield->width * minefield->height / 4 + 64;
+}
+static void minefield_mark_dirty(struct Minefield *minefield, size_t x, size_t y) {
+    struct Tile *tile = minefield_get_tile(minefield, x, y);
+    if (minefield->dirty.all || (tile->bits & TILE_DIRTY_BIT)) {
+        return;
+    }
+    if (minefield->dirty.len == minefield->dirty.cap) {
+        size_t cap = minefield->dirty.cap ? minefield->dirty.cap * 2 : 64;
+        if (cap > minefield_dirty_limit(minefield)) {
+            cap = minefield_dirty_limit(minefield);
+        }
+        size_t *items = cap > minefield->dirty.cap ? realloc(minefield->dirty.items, cap * sizeof(size_t)) : NULL;
+        if (!items) {
+            // too many (or out of memory), either way a full redraw covers it
+            minefield->dirty.all = true;
+            return;
+        }
+        minefield->dirty.items = items;
+        minefield->dirty.cap = cap;
+    }
+    tile->bits |= TILE_DIRTY_BIT;
+    minefield->dirty.items[minefield->dirty.len++] = y * minefield->width + x;
+}
+
+void minefield_set_cursor(struct Minefield *minefield, int x, int y) {
+    minefield_mark_dirty(minefield, minefield->cur.x, minefield->cur.y);
+    minefield->cur.x = x;
+    minefield->cur.y = y;
+    minefield_mark_dirty(minefield, x, y);
+}
+
+void minefield_mark_all_dirty(struct Minefield *minefield) {
+    minefield->dirty.all = true;
+}
+
+void minefield_clear_dirty(struct Minefield *minefield) {
+    // only listed tiles ever get the dirty bit, so this doesn't need to look at the whole board
+    for (size_t i = 0; i < minefield->dirty.len; i++) {
+        size_t offset = minefield->dirty.items[i];
+        minefield_get_tile(minefield, offset % minefield->width, offset / minefield->width)->bits &= ~TILE_DIRTY_BIT;
+    }
+    minefield->dirty.len = 0;
+    minefield->dirty.all = false;
 }
 
 // set a tile as a mine and increment surrounding
 static void minefield_set_mine(struct Minefield *minefield, size_t x, size_t y) {
     struct Tile *tile = minefield_get_tile(minefield, x, y);
-    tile->mine = true;
+    tile_set_mine(tile);
 
     size_t x_start = x > 0 ? x - 1 : 0;
     size_t y_start = y > 0 ? y - 1 : 0;
@@ -41,77 +206,930 @@ static void minefield_set_mine(struct Minefield *minefield, size_t x, size_t y)
     size_t y_end = y < minefield->height - 1 ? y + 1 : y;
     for (size_t x1 = x_start; x1 <= x_end; x1++) {
         for (size_t y1 = y_start; y1 <= y_end; y1++) {
-            minefield_get_tile(minefield, x1, y1)->surrounding++;
+            tile_add_surrounding(minefield_get_tile(minefield, x1, y1));
+        }
+    }
+}
+// the 3x3 around the first click that mines can't be placed in, clipped to the edges of the board
+struct SafeZone {
+    size_t x_start, y_start;
+    size_t width, height;
+};
+static struct SafeZone minefield_safe_zone(size_t width, size_t height, size_t x, size_t y) {
+    size_t x_start = x > 0 ? x - 1 : 0;
+    size_t y_start = y > 0 ? y - 1 : 0;
+    size_t x_end = x < width - 1 ? x + 1 : x;
+    size_t y_end = y < height - 1 ? y + 1 : y;
+    return (struct SafeZone){ x_start, y_start, x_end - x_start + 1, y_end - y_start + 1 };
+}
+// map an index in [0, width * height - safe tiles) to a tile, going in row order and skipping the safe zone
+static void minefield_candidate_coords(size_t width, struct SafeZone *safe, size_t i, size_t *x, size_t *y) {
+    size_t before = safe->y_start * width; // tiles in the rows above the safe zone
+    size_t row_len = width - safe->width; // tiles left in a row that crosses the safe zone
+    if (i < before) {
+        *x = i % width;
+        *y = i / width;
+        return;
+    }
+    i -= before;
+    if (i < row_len * safe->height) {
+        *x = i % row_len;
+        *y = safe->y_start + i / row_len;
+        if (*x >= safe->x_start) {
+            *x += safe->width;
+        }
+        return;
+    }
+    i -= row_len * safe->height;
+    *x = i % width;
+    *y = safe->y_start + safe->height + i / width;
+}
+// picks exactly `mines` distinct tiles outside the safe zone, uniformly, using Robert Floyd's sampling algorithm
+// takes O(mines) time no matter how full the board is, and uses the caller's own record of placed mines
+// as the "already picked" set
+void minefield_sample_mines(size_t width, size_t height, size_t mines, size_t cur_x, size_t cur_y, struct Rng *rng,
+                            bool (*is_placed)(void *ctx, size_t x, size_t y), void (*place)(void *ctx, size_t x, size_t y),
+                            void *ctx) {
+    struct SafeZone safe = minefield_safe_zone(width, height, cur_x, cur_y);
+    size_t candidates = width * height - safe.width * safe.height;
+    assert(mines <= candidates);
+
+    for (size_t j = candidates - mines; j < candidates; j++) {
+        size_t x, y;
+        minefield_candidate_coords(width, &safe, rng_below(rng, j + 1), &x, &y);
+        if (is_placed(ctx, x, y)) {
+            // already picked, so take j instead; it can't have been picked yet since everything so far was < j
+            minefield_candidate_coords(width, &safe, j, &x, &y);
+        }
+        place(ctx, x, y);
+    }
+}
+
+static bool minefield_sample_is_placed(void *ctx, size_t x, size_t y) {
+    return tile_is_mine(minefield_get_tile(ctx, x, y));
+}
+static void minefield_sample_place(void *ctx, size_t x, size_t y) {
+    minefield_set_mine(ctx, x, y);
+}
+
+// mines placed one bit per tile, each row starting on a new word
+struct MinePlane {
+    uint64_t *words;
+    size_t row_words;
+};
+static bool minefield_plane_is_placed(void *ctx, size_t x, size_t y) {
+    struct MinePlane *plane = ctx;
+    return plane->words[y * plane->row_words + x / 64] >> (x % 64) & 1;
+}
+static void minefield_plane_place(void *ctx, size_t x, size_t y) {
+    struct MinePlane *plane = ctx;
+    plane->words[y * plane->row_words + x / 64] |= (uint64_t)1 << (x % 64);
+}
+// each tile and its left and right neighbors in one row of the plane, as a 2 bit sum from a full adder
+// (the same row sums bitboard_count_around starts with)
+static void minefield_plane_row_sums(const uint64_t *row, size_t row_words, uint64_t *ones, uint64_t *twos) {
+    for (size_t i = 0; i < row_words; i++) {
+        uint64_t a = row[i];
+        // bits past the right edge are never set, so nothing leaks in from there
+        uint64_t left = a << 1 | (i > 0 ? row[i - 1] >> 63 : 0);
+        uint64_t right = a >> 1 | (i + 1 < row_words ? row[i + 1] << 63 : 0);
+        ones[i] = a ^ left ^ right;
+        twos[i] = (a & left) | (right & (a ^ left));
+    }
+}
+// the low 8 bits of `bits` as 8 bytes that are each 0 or 1, the first bit in the lowest byte
+static inline uint64_t minefield_plane_spread(uint64_t bits) {
+    bits &= 0xff;
+    bits = (bits | bits << 28) & 0x0000000f0000000f;
+    bits = (bits | bits << 14) & 0x0003000300030003;
+    bits = (bits | bits << 7) & 0x0101010101010101;
+    return bits;
+}
+// or the first len (up to 64) tiles of a bit-sliced count and mine plane into the tiles, bit i of
+// the tile bits comes from planes[i]
+static void minefield_plane_store(struct Tile *tiles, size_t len, const uint64_t planes[5]) {
+    size_t x = 0;
+#ifdef __SSE2__
+    // 16 tiles at a time: copy each plane's 16 bits into every byte, keep the byte's own bit,
+    // and turn it into the plane's bit in the tile
+    const __m128i select = _mm_set_epi8((char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                        (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    for (; x + 16 <= len; x += 16) {
+        __m128i bytes = _mm_setzero_si128();
+        for (int plane = 0; plane < 5; plane++) {
+            __m128i bits = _mm_cvtsi32_si128((int)(planes[plane] >> x & 0xffff));
+            bits = _mm_unpacklo_epi8(bits, bits);
+            bits = _mm_unpacklo_epi16(bits, bits);
+            bits = _mm_unpacklo_epi32(bits, bits); // the low 8 bits in bytes 0-7, the high 8 in bytes 8-15
+            bits = _mm_cmpeq_epi8(_mm_and_si128(bits, select), select);
+            bytes = _mm_or_si128(bytes, _mm_and_si128(bits, _mm_set1_epi8((char)(1 << plane))));
+        }
+        __m128i *out = (__m128i *)&tiles[x];
+        _mm_storeu_si128(out, _mm_or_si128(_mm_loadu_si128(out), bytes));
+    }
+#endif
+    for (; x < len; x += 8) {
+        uint64_t bytes = 0;
+        for (int plane = 0; plane < 5; plane++) {
+            bytes |= minefield_plane_spread(planes[plane] >> x) << plane;
+        }
+        size_t end = len - x < 8 ? len - x : 8;
+        for (size_t k = 0; k < end; k++) {
+            tiles[x + k].bits |= (uint8_t)(bytes >> (8 * k));
         }
     }
 }
+// minefield_plane_store for the `len` tiles from (x, y) to the right, x has to be a multiple of 64
+// with blocks, only the tiles in one block are next to each other, so they're stored a block at a time
+static void minefield_plane_store_at(struct Minefield *minefield, size_t x, size_t y, size_t len,
+                                     const uint64_t planes[5]) {
+    size_t run = minefield->block_shift ? (size_t)1 << minefield->block_shift : len;
+    for (size_t done = 0; done < len; done += run) {
+        uint64_t shifted[5];
+        for (int plane = 0; plane < 5; plane++) {
+            shifted[plane] = planes[plane] >> done;
+        }
+        minefield_plane_store(minefield_get_tile(minefield, x + done, y), len - done < run ? len - done : run, shifted);
+    }
+}
+// fill in the whole board from the plane in one pass, 64 tiles at a time: the row sums of the row
+// and the rows above and below are added bit-sliced, then minefield_plane_store spreads the bits of
+// the counts out into the tiles. sums has room for 7 rows of row_words, the last one stays 0 for the edges
+static void minefield_plane_apply(struct Minefield *minefield, struct MinePlane *plane, uint64_t *sums) {
+    size_t width = minefield->width;
+    size_t row_words = plane->row_words;
+    uint64_t *ones[3], *twos[3];
+    for (size_t i = 0; i < 3; i++) {
+        ones[i] = sums + 2 * i * row_words;
+        twos[i] = sums + (2 * i + 1) * row_words;
+    }
+    uint64_t *empty = sums + 6 * row_words;
+    memset(sums, 0, 7 * row_words * sizeof(uint64_t));
+    // ones[0]/twos[0] are the row above, [1] this row and [2] the row below
+    minefield_plane_row_sums(plane->words, row_words, ones[1], twos[1]);
+    for (size_t y = 0; y < minefield->height; y++) {
+        const uint64_t *above_ones = y > 0 ? ones[0] : empty, *above_twos = y > 0 ? twos[0] : empty;
+        const uint64_t *below_ones = empty, *below_twos = empty;
+        if (y + 1 < minefield->height) {
+            minefield_plane_row_sums(plane->words + (y + 1) * row_words, row_words, ones[2], twos[2]);
+            below_ones = ones[2];
+            below_twos = twos[2];
+        }
+        const uint64_t *mines = plane->words + y * row_words;
+        for (size_t i = 0; i < row_words; i++) {
+            // the ones column of all three, carrying into the twos column
+            uint64_t o = ones[1][i], u = above_ones[i], d = below_ones[i];
+            uint64_t bit0 = o ^ u ^ d;
+            uint64_t carry = (o & u) | (d & (o ^ u));
+            // the twos column: three inputs plus the carry, a sum of up to 4 twos
+            uint64_t t = twos[1][i], tu = above_twos[i], td = below_twos[i];
+            uint64_t sum = t ^ tu ^ td;
+            uint64_t carry1 = (t & tu) | (td & (t ^ tu));
+            uint64_t bit1 = sum ^ carry;
+            uint64_t carry2 = sum & carry;
+            // carry1 and carry2 are both worth 4, and can both be set (2 + 2 + 2 + 2 = 8)
+            uint64_t planes[5] = { bit0, bit1, carry1 ^ carry2, carry1 & carry2, mines[i] };
+            size_t x = i * 64;
+            minefield_plane_store_at(minefield, x, y, width - x < 64 ? width - x : 64, planes);
+        }
+        uint64_t *oldest = ones[0];
+        ones[0] = ones[1];
+        ones[1] = ones[2];
+        ones[2] = oldest;
+        oldest = twos[0];
+        twos[0] = twos[1];
+        twos[1] = twos[2];
+        twos[2] = oldest;
+    }
+}
+// returns false without touching the rng or the tiles if there isn't memory for the plane
+static bool minefield_populate_plane(struct Minefield *minefield) {
+    struct MinePlane plane = { .row_words = (minefield->width + 63) / 64 };
+    plane.words = calloc(plane.row_words * minefield->height, sizeof(uint64_t));
+    uint64_t *sums = malloc(7 * plane.row_words * sizeof(uint64_t));
+    if (!plane.words || !sums) {
+        free(plane.words);
+        free(sums);
+        return false;
+    }
+    minefield_sample_mines(minefield->width, minefield->height, minefield->mines, minefield->cur.x, minefield->cur.y,
+                           &minefield->rng, minefield_plane_is_placed, minefield_plane_place, &plane);
+    minefield_plane_apply(minefield, &plane, sums);
+    free(plane.words);
+    free(sums);
+    return true;
+}
+
+// union-find root of a zero, halving the path on the way up
+static uint32_t minefield_openings_find(uint32_t *parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+// sets are always joined under the lower offset, so a set's root is its first tile in row order
+static void minefield_openings_union(uint32_t *parent, uint32_t a, uint32_t b) {
+    a = minefield_openings_find(parent, a);
+    b = minefield_openings_find(parent, b);
+    if (a < b) {
+        parent[b] = a;
+    } else {
+        parent[a] = b;
+    }
+}
+// the different openings (ids) next to a tile, at most 4 since touching zeroes are in the same one
+static int minefield_openings_around(struct Minefield *minefield, size_t x, size_t y, uint32_t around[4]) {
+    // away from the edges: go around the 8 tiles in a ring, where each tile touches the next, so a run
+    // of zeroes is always one opening and only the start of a run can be a new one. a number always has
+    // a mine around it, so the ring is never all one run
+    size_t width = minefield->width;
+    if (x > 0 && x + 1 < width && y > 0 && y + 1 < minefield->height) {
+        const uint32_t *up = &minefield->openings.ids[(y - 1) * width + x];
+        const uint32_t *down = up + 2 * width;
+        const uint32_t ring[8] = { up[-1], up[0], up[1], up[width + 1], down[1], down[0], down[-1], up[width - 1] };
+        // on full boards most numbers aren't next to any zero
+        if ((ring[0] | ring[1] | ring[2] | ring[3] | ring[4] | ring[5] | ring[6] | ring[7]) == 0) {
+            return 0;
+        }
+        int len = 0;
+        for (int i = 0; i < 8; i++) {
+            uint32_t id = ring[i];
+            if (id == 0 || ring[(i + 7) % 8] == id) {
+                continue;
+            }
+            bool seen = false;
+            for (int j = 0; j < len; j++) {
+                seen |= around[j] == id;
+            }
+            if (!seen) {
+                around[len++] = id;
+            }
+        }
+        return len;
+    }
+    int len = 0;
+    size_t x_start = x > 0 ? x - 1 : 0;
+    size_t y_start = y > 0 ? y - 1 : 0;
+    size_t x_end = x < minefield->width - 1 ? x + 1 : x;
+    size_t y_end = y < minefield->height - 1 ? y + 1 : y;
+    for (size_t y1 = y_start; y1 <= y_end; y1++) {
+        for (size_t x1 = x_start; x1 <= x_end; x1++) {
+            uint32_t id = minefield->openings.ids[y1 * minefield->width + x1];
+            bool seen = id == 0;
+            for (int i = 0; i < len && !seen; i++) {
+                seen = around[i] == id;
+            }
+            if (!seen && len < 4) {
+                around[len++] = id;
+            }
+        }
+    }
+    return len;
+}
+void minefield_index_openings(struct Minefield *minefield) {
+    minefield_free_openings(minefield);
+    size_t width = minefield->width;
+    size_t tiles_len = width * minefield->height;
+    if (tiles_len > UINT32_MAX) {
+        return;
+    }
+    uint32_t *ids = calloc(tiles_len, sizeof(uint32_t));
+    uint32_t *parent = malloc(tiles_len * sizeof(uint32_t));
+    if (!ids || !parent) {
+        free(ids);
+        free(parent);
+        return;
+    }
+    // join every zero with the zeroes before it (left, and the three above). zeroes before it that
+    // touch each other are already joined, so the one above is enough when it's a zero; otherwise
+    // it's up-right plus whichever of left and up-left is a zero (those two touch)
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (tile_is_mine(tile) || tile_surrounding(tile) != 0) {
+                continue;
+            }
+            uint32_t offset = y * width + x;
+            ids[offset] = 1; // just marks it as a zero for now
+            parent[offset] = offset;
+            if (y > 0 && ids[offset - width]) {
+                parent[offset] = parent[offset - width];
+                continue;
+            }
+            if (x > 0 && ids[offset - 1]) {
+                parent[offset] = parent[offset - 1];
+            } else if (x > 0 && y > 0 && ids[offset - width - 1]) {
+                parent[offset] = parent[offset - width - 1];
+            }
+            if (y > 0 && x + 1 < width && ids[offset - width + 1]) {
+                minefield_openings_union(parent, offset, offset - width + 1);
+            }
+        }
+    }
+    // number the openings in row order; a root comes before the rest of its set, so it's numbered first
+    size_t count = 0;
+    for (size_t offset = 0; offset < tiles_len; offset++) {
+        if (ids[offset]) {
+            uint32_t root = minefield_openings_find(parent, offset);
+            ids[offset] = root == offset ? ++count : ids[root];
+        }
+    }
+    free(parent);
+    minefield->openings.ids = ids;
+
+    // then list each opening's tiles, counting first so they can all go in one array. a zero is only
+    // ever in its own opening, only numbers have to look around for theirs
+    size_t *start = calloc(count + 1, sizeof(size_t));
+    if (!start) {
+        minefield_free_openings(minefield);
+        return;
+    }
+    size_t isolated = 0; // numbers that aren't next to any opening
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            uint32_t id = ids[y * width + x];
+            if (id) {
+                start[id]++; // counted one up, so the sums below come out as starts
+                continue;
+            }
+            if (tile_is_mine(minefield_get_tile(minefield, x, y))) {
+                continue;
+            }
+            uint32_t around[4];
+            int len = minefield_openings_around(minefield, x, y, around);
+            for (int i = 0; i < len; i++) {
+                start[around[i]]++;
+            }
+            if (len == 0) {
+                isolated++;
+            }
+        }
+    }
+    for (size_t k = 0; k < count; k++) {
+        start[k + 1] += start[k];
+    }
+    uint32_t *tiles = malloc(start[count] * sizeof(uint32_t));
+    if (!tiles) {
+        free(start);
+        minefield_free_openings(minefield);
+        return;
+    }
+    // start[k] is where opening k's next tile goes, so after this it has moved up to start[k + 1]
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            uint32_t offset = y * width + x;
+            if (ids[offset]) {
+                tiles[start[ids[offset] - 1]++] = offset;
+                continue;
+            }
+            if (tile_is_mine(minefield_get_tile(minefield, x, y))) {
+                continue;
+            }
+            uint32_t around[4];
+            int len = minefield_openings_around(minefield, x, y, around);
+            for (int i = 0; i < len; i++) {
+                tiles[start[around[i] - 1]++] = offset;
+            }
+        }
+    }
+    for (size_t k = count; k > 0; k--) {
+        start[k] = start[k - 1];
+    }
+    start[0] = 0;
+    minefield->openings.start = start;
+    minefield->openings.tiles = tiles;
+    minefield->openings.count = count;
+    minefield->openings.bv3 = count + isolated;
+    minefield->openings.built = true;
+}
+
 void minefield_populate(struct Minefield *minefield) {
-    // randomly spread mines
-    for (size_t i = 0; i < minefield->mines;) {
-        // non inclusive; don't worry, i didn't forget about starting at 0
-        size_t x = (rand() % (minefield->width));
-        size_t y = (rand() % (minefield->height));
-
-        // TODO: maybe calculate using distance formula
-        // don't generate mines in a 3x3 centered on the cursor
-        if ((x >= minefield->cur.x - 1) &&
-            (y >= minefield->cur.y - 1) &&
-            (x <= minefield->cur.x + 1) &&
-            (y <= minefield->cur.y + 1)) {
-            continue;
+    rng_seed(&minefield->rng, minefield->seed);
+    // adding every mine to its neighbors right away is 9 scattered writes per mine; on big, full boards
+    // it's much faster to drop the mines into a small bitplane first and count them all in one pass
+    size_t tiles = minefield->width * minefield->height;
+    bool planed = tiles >= POPULATE_PLANE_MIN_TILES && minefield->mines >= tiles / POPULATE_PLANE_MIN_DENSITY
+               && minefield_populate_plane(minefield);
+    if (!planed) {
+        minefield_sample_mines(minefield->width, minefield->height, minefield->mines, minefield->cur.x,
+                               minefield->cur.y, &minefield->rng, minefield_sample_is_placed, minefield_sample_place,
+                               minefield);
+    }
+    // flags can go down before the first click, when there were no mines to be right about yet
+    if (minefield->placed_flags) {
+        minefield->correct_flags = 0;
+        for (size_t y = 0; y < minefield->height; y++) {
+            for (size_t x = 0; x < minefield->width; x++) {
+                struct Tile *tile = minefield_get_tile(minefield, x, y);
+                minefield->correct_flags += tile_is_flagged(tile) && tile_is_mine(tile);
+            }
+        }
+    }
+    if (minefield->index_openings) {
+        minefield_index_openings(minefield);
+    }
+}
+
+void minefield_adopt_tiles(struct Minefield *minefield, struct Tile *tiles, void *map, size_t map_len) {
+    minefield_free_tiles(minefield);
+    minefield->tiles = tiles;
+    minefield->tiles_map.addr = map;
+    minefield->tiles_map.len = map_len;
+}
+
+size_t minefield_tiles_len(const struct Minefield *minefield) {
+    if (!minefield->block_shift) {
+        return minefield->width * minefield->height;
+    }
+    size_t block = (size_t)1 << minefield->block_shift;
+    size_t blocks_high = (minefield->height + block - 1) / block;
+    return minefield->blocks_wide * blocks_high * block * block;
+}
+
+struct Tile *minefield_get_tile(struct Minefield *minefield, size_t x, size_t y) {
+    if (!minefield->block_shift) {
+        // tile array is treated as a sequential list of rows, each row containing `minefield.cols` elements
+        size_t offset = y * minefield->width;
+        return &minefield->tiles[offset + x];
+    }
+    // the block the tile is in, then the tile's row and column inside of it
+    unsigned shift = minefield->block_shift;
+    size_t mask = ((size_t)1 << shift) - 1;
+    size_t block = (y >> shift) * minefield->blocks_wide + (x >> shift);
+    return &minefield->tiles[(block << 2 * shift) + ((y & mask) << shift) + (x & mask)];
+}
+
+// the parallel flood fill: every thread has a stack of zeroes only it touches, and shares the oldest
+// half of it once it gets long. threads that run out take back what they shared, then steal half of
+// someone else's. a tile belongs to whichever thread sets its visible bit first (with an atomic or),
+// so every tile is revealed exactly once, and the revealed tiles are the same as a sequential fill's:
+// both reveal everything reachable through zeroes. the journal, dirty list and solver aren't thread
+// safe, so each thread lists what it revealed and the calling thread goes through those afterwards
+#define PARALLEL_REVEAL_MAX_THREADS 64
+static const size_t PARALLEL_REVEAL_LOCAL_MAX = 512; // tiles a thread keeps to itself before sharing
+
+// tile offsets (y * width + x)
+struct RevealList {
+    size_t *items;
+    size_t len;
+    size_t cap;
+};
+// returns false if out of memory
+static bool reveal_list_push(struct RevealList *list, size_t offset) {
+    if (list->len == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 256;
+        size_t *items = realloc(list->items, cap * sizeof(size_t));
+        if (!items) {
+            return false;
+        }
+        list->items = items;
+        list->cap = cap;
+    }
+    list->items[list->len++] = offset;
+    return true;
+}
+// the shared part of a thread's work, [start, end) of items; the owner adds and takes at the end,
+// thieves take from the start
+struct RevealDeque {
+    pthread_mutex_t lock;
+    struct RevealList list;
+    size_t start;
+};
+struct RevealPool {
+    struct Minefield *minefield; // only the visible bits change while the workers run
+    struct RevealWorker *workers;
+    int len; // workers, including any whose thread couldn't be started (their work still gets stolen)
+    int threads; // workers that are running, taken down with __atomic_sub_fetch if one can't start
+    int idle; // workers that found nothing to do, they're all done once this reaches threads
+    // out of memory somewhere: every worker stops, and everything they revealed is hidden again
+    bool failed;
+};
+struct RevealWorker {
+    struct RevealPool *pool;
+    struct RevealList local;
+    struct RevealDeque shared;
+    struct RevealList revealed;
+    bool idle;
+};
+
+static bool reveal_pool_failed(struct RevealPool *pool) {
+    return __atomic_load_n(&pool->failed, __ATOMIC_RELAXED);
+}
+static void reveal_pool_fail(struct RevealPool *pool) {
+    __atomic_store_n(&pool->failed, true, __ATOMIC_RELAXED);
+}
+
+// move the oldest half of the local stack to the shared one
+static void reveal_worker_share(struct RevealWorker *worker) {
+    size_t half = worker->local.len / 2;
+    pthread_mutex_lock(&worker->shared.lock);
+    for (size_t i = 0; i < half; i++) {
+        if (!reveal_list_push(&worker->shared.list, worker->local.items[i])) {
+            reveal_pool_fail(worker->pool);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&worker->shared.lock);
+    memmove(worker->local.items, worker->local.items + half, (worker->local.len - half) * sizeof(size_t));
+    worker->local.len -= half;
+}
+// take some of the newest shared tiles back, or the oldest half of someone else's
+// thieves that were idle stop being idle while they still hold the victim's lock, so the pool never
+// looks finished while work is being handed over
+static bool reveal_worker_take(struct RevealWorker *worker, struct RevealWorker *from) {
+    struct RevealDeque *shared = &from->shared;
+    pthread_mutex_lock(&shared->lock);
+    size_t available = shared->list.len - shared->start;
+    if (available == 0) {
+        pthread_mutex_unlock(&shared->lock);
+        return false;
+    }
+    if (worker->idle) {
+        __atomic_sub_fetch(&worker->pool->idle, 1, __ATOMIC_RELAXED);
+        worker->idle = false;
+    }
+    if (from == worker) {
+        size_t max = PARALLEL_REVEAL_LOCAL_MAX / 2;
+        size_t count = available < max ? available : max;
+        for (size_t i = 0; i < count; i++) {
+            if (!reveal_list_push(&worker->local, shared->list.items[--shared->list.len])) {
+                reveal_pool_fail(worker->pool);
+                break;
+            }
+        }
+    } else {
+        size_t count = (available + 1) / 2;
+        for (size_t i = 0; i < count; i++) {
+            if (!reveal_list_push(&worker->local, shared->list.items[shared->start++])) {
+                reveal_pool_fail(worker->pool);
+                break;
+            }
+        }
+    }
+    if (shared->start == shared->list.len) {
+        shared->start = shared->list.len = 0;
+    }
+    pthread_mutex_unlock(&shared->lock);
+    return true;
+}
+// true if there's more to do, false once every worker is out of work (or the pool failed)
+static bool reveal_worker_find_work(struct RevealWorker *worker) {
+    struct RevealPool *pool = worker->pool;
+    if (reveal_worker_take(worker, worker)) {
+        return true;
+    }
+    for (;;) {
+        if (reveal_pool_failed(pool)) {
+            return false;
+        }
+        for (int i = 0; i < pool->len; i++) {
+            if (&pool->workers[i] != worker && reveal_worker_take(worker, &pool->workers[i])) {
+                return true;
+            }
+        }
+        if (!worker->idle) {
+            // only the owner adds to its shared stack, and it's empty, so nothing can show up there anymore
+            worker->idle = true;
+            __atomic_add_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+        }
+        if (__atomic_load_n(&pool->idle, __ATOMIC_RELAXED) == __atomic_load_n(&pool->threads, __ATOMIC_RELAXED)) {
+            return false;
+        }
+        sched_yield();
+    }
+}
+static void *reveal_worker_run(void *arg) {
+    struct RevealWorker *worker = arg;
+    struct RevealPool *pool = worker->pool;
+    struct Minefield *minefield = pool->minefield;
+    while (!reveal_pool_failed(pool) && (worker->local.len > 0 || reveal_worker_find_work(worker))) {
+        size_t offset = worker->local.items[--worker->local.len];
+        size_t x = offset % minefield->width;
+        size_t y = offset / minefield->width;
+
+        size_t x_start = x > 0 ? x - 1 : 0;
+        size_t y_start = y > 0 ? y - 1 : 0;
+        size_t x_end = x < minefield->width - 1 ? x + 1 : x;
+        size_t y_end = y < minefield->height - 1 ? y + 1 : y;
+        for (size_t y1 = y_start; y1 <= y_end; y1++) {
+            for (size_t x1 = x_start; x1 <= x_end; x1++) {
+                struct Tile *surtile = minefield_get_tile(minefield, x1, y1);
+                // mine and flag bits don't change while this runs, and zeroes have no mines around them
+                uint8_t bits = __atomic_load_n(&surtile->bits, __ATOMIC_RELAXED);
+                if (bits & (TILE_VISIBLE_BIT | TILE_FLAGGED_BIT)) {
+                    continue;
+                }
+                if (__atomic_fetch_or(&surtile->bits, TILE_VISIBLE_BIT, __ATOMIC_RELAXED) & TILE_VISIBLE_BIT) {
+                    continue; // another thread got to it first
+                }
+                if (!reveal_list_push(&worker->revealed, y1 * minefield->width + x1)) {
+                    // it isn't listed anywhere, so it's hidden again right here
+                    __atomic_and_fetch(&surtile->bits, (uint8_t)~TILE_VISIBLE_BIT, __ATOMIC_RELAXED);
+                    reveal_pool_fail(pool);
+                    return NULL;
+                }
+                if ((bits & TILE_SURROUNDING_MASK) == 0) {
+                    if (!reveal_list_push(&worker->local, y1 * minefield->width + x1)) {
+                        reveal_pool_fail(pool);
+                        return NULL;
+                    }
+                    if (worker->local.len > PARALLEL_REVEAL_LOCAL_MAX) {
+                        reveal_worker_share(worker);
+                    }
+                }
+            }
+        }
+    }
+    return NULL;
+}
+// finish a flood fill from the `len` zeroes on minefield.reveal_stack, which are already visible
+// returns false without changing anything if out of memory
+static bool minefield_reveal_parallel(struct Minefield *minefield, size_t len) {
+    int threads = minefield->reveal_threads > PARALLEL_REVEAL_MAX_THREADS ? PARALLEL_REVEAL_MAX_THREADS
+                                                                          : minefield->reveal_threads;
+    struct RevealWorker *workers = calloc(threads, sizeof(struct RevealWorker));
+    if (!workers) {
+        return false;
+    }
+    struct RevealPool pool = { .minefield = minefield, .workers = workers, .len = threads, .threads = threads, .idle = 0 };
+    for (int i = 0; i < threads; i++) {
+        workers[i].pool = &pool;
+        pthread_mutex_init(&workers[i].shared.lock, NULL);
+    }
+    // deal the zeroes out, so every thread starts with something
+    for (size_t i = 0; i < len && !pool.failed; i++) {
+        pool.failed = !reveal_list_push(&workers[i % threads].shared.list, minefield->reveal_stack.items[i]);
+    }
+
+    pthread_t ids[PARALLEL_REVEAL_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads && !pool.failed; i++) {
+        if (pthread_create(&ids[started], NULL, reveal_worker_run, &workers[i]) == 0) {
+            started++;
+        } else {
+            __atomic_sub_fetch(&pool.threads, 1, __ATOMIC_RELAXED);
+        }
+    }
+    reveal_worker_run(&workers[0]);
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        struct RevealList *revealed = &workers[i].revealed;
+        // the board goes back to how it was, the caller carries on without threads
+        for (size_t j = 0; pool.failed && j < revealed->len; j++) {
+            size_t offset = revealed->items[j];
+            minefield_get_tile(minefield, offset % minefield->width, offset / minefield->width)->bits &= ~TILE_VISIBLE_BIT;
+        }
+        for (size_t j = 0; !pool.failed && j < revealed->len; j++) {
+            size_t offset = revealed->items[j];
+            size_t x = offset % minefield->width;
+            size_t y = offset / minefield->width;
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (minefield->journal && minefield->journal->recording) {
+                journal_record(minefield->journal, offset, tile->bits & ~(TILE_VISIBLE_BIT | TILE_DIRTY_BIT));
+            }
+            minefield_mark_dirty(minefield, x, y);
+            minefield_notify_revealed(minefield, x, y);
+        }
+        minefield->visible_tiles += pool.failed ? 0 : revealed->len;
+        free(revealed->items);
+        free(workers[i].local.items);
+        free(workers[i].shared.list.items);
+        pthread_mutex_destroy(&workers[i].shared.lock);
+    }
+    free(workers);
+    return !pool.failed;
+}
+
+// reveal the whole opening the hidden zero at offset is in straight from the index. only done if no
+// zero in it was revealed or flagged yet, since either of those stops a flood fill partway; then this
+// reveals exactly what the flood fill would have. returns false, having done nothing, otherwise
+static bool minefield_reveal_opening(struct Minefield *minefield, size_t offset) {
+    if (!minefield->openings.built) {
+        return false;
+    }
+    uint32_t *ids = minefield->openings.ids;
+    size_t opening = ids[offset] - 1;
+    uint32_t *start = &minefield->openings.tiles[minefield->openings.start[opening]];
+    uint32_t *end = &minefield->openings.tiles[minefield->openings.start[opening + 1]];
+    for (uint32_t *i = start; i < end; i++) {
+        struct Tile *tile = minefield_get_tile(minefield, *i % minefield->width, *i / minefield->width);
+        if (ids[*i] && (tile_is_visible(tile) || tile_is_flagged(tile))) {
+            return false;
         }
-        if (minefield_get_tile(minefield, x, y)->mine) {
+    }
+    for (uint32_t *i = start; i < end; i++) {
+        size_t x = *i % minefield->width;
+        size_t y = *i / minefield->width;
+        struct Tile *tile = minefield_get_tile(minefield, x, y);
+        if (tile_is_visible(tile) || tile_is_flagged(tile)) {
             continue;
         }
+        minefield_record_change(minefield, x, y, tile);
+        tile_set_visible(tile);
+        minefield->visible_tiles++;
+        minefield_mark_dirty(minefield, x, y);
+        minefield_notify_revealed(minefield, x, y);
+    }
+    return true;
+}
 
-        minefield_set_mine(minefield, x, y);
-        i++;
+// push a zero on minefield.reveal_stack, growing it if it's full
+// returns false if out of memory
+static bool minefield_reveal_push(struct Minefield *minefield, size_t *len, size_t offset) {
+    if (*len == minefield->reveal_stack.cap) {
+        // a tile is never on the stack twice, so it never needs more than the board
+        size_t cap = minefield->reveal_stack.cap * 2;
+        if (cap > minefield->width * minefield->height) {
+            cap = minefield->width * minefield->height;
+        }
+        size_t *items = cap > *len ? realloc(minefield->reveal_stack.items, cap * sizeof(size_t)) : NULL;
+        if (!items) {
+            return false;
+        }
+        minefield->reveal_stack.items = items;
+        minefield->reveal_stack.cap = cap;
     }
+    minefield->reveal_stack.items[(*len)++] = offset;
+    return true;
 }
 
-struct Tile *minefield_get_tile(struct Minefield *minefield, size_t x, size_t y) {
-    // tile array is treated as a sequential list of rows, each row containing `minefield.cols` elements
-    size_t offset = y * minefield->width;
-    return &minefield->tiles[offset + x];
+// a push failed in the middle of a flood fill, but the zero that didn't fit is already visible. once the
+// stack is empty this finds every visible zero that still has hidden (unflagged) tiles around it and
+// pushes them again
+// returns true if some of those didn't fit either, then it has to run again after they're done
+static bool minefield_reveal_rescan(struct Minefield *minefield, size_t *len) {
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (!tile_is_visible(tile) || tile_is_mine(tile) || tile_surrounding(tile) != 0) {
+                continue;
+            }
+            bool pending = false;
+            size_t x_start = x > 0 ? x - 1 : 0;
+            size_t y_start = y > 0 ? y - 1 : 0;
+            size_t x_end = x < minefield->width - 1 ? x + 1 : x;
+            size_t y_end = y < minefield->height - 1 ? y + 1 : y;
+            for (size_t y1 = y_start; y1 <= y_end && !pending; y1++) {
+                for (size_t x1 = x_start; x1 <= x_end && !pending; x1++) {
+                    struct Tile *surtile = minefield_get_tile(minefield, x1, y1);
+                    pending = !tile_is_visible(surtile) && !tile_is_flagged(surtile);
+                }
+            }
+            if (pending && !minefield_reveal_push(minefield, len, y * minefield->width + x)) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 // output: bool - false if the clicked tile was a mine, true otherwise
 bool minefield_reveal_tile(struct Minefield *minefield, size_t x, size_t y) {
     struct Tile *tile = minefield_get_tile(minefield, x, y);
-    assert(!tile->flagged);
-    bool start_visible = tile->visible;
-    if (tile->mine) {
+    assert(!tile_is_flagged(tile));
+    bool start_visible = tile_is_visible(tile);
+    if (tile_is_mine(tile)) {
         return false;
     }
-    tile->visible = true;
-    if (tile->surrounding != 0 && !start_visible) {
+    if (!start_visible && tile_surrounding(tile) == 0 && minefield_reveal_opening(minefield, y * minefield->width + x)) {
+        return true;
+    }
+    if (!start_visible) {
+        minefield_record_change(minefield, x, y, tile);
+        tile_set_visible(tile);
+        minefield->visible_tiles++;
+        minefield_mark_dirty(minefield, x, y);
+        minefield_notify_revealed(minefield, x, y);
+    }
+    if (tile_surrounding(tile) != 0 && !start_visible) {
         return true;
     }
 
-    size_t x_start = x > 0 ? x - 1 : 0;
-    size_t y_start = y > 0 ? y - 1 : 0;
-    // TODO: this is kinda ugly
-    size_t x_end = x < minefield->width - 1 ? x + 1 : x;
-    size_t y_end = y < minefield->height - 1 ? y + 1 : y;
+    // tiles are marked visible as soon as they are pushed, so each one is only ever pushed once. a zero
+    // that couldn't be pushed (out of memory) is left for minefield_reveal_rescan to find
     bool no_mines = true;
-    for (size_t x1 = x_start; x1 <= x_end; x1++) {
+    bool overflowed = false;
+    size_t len = 0;
+    size_t revealed = 0;
+    bool parallel = minefield->reveal_threads > 1;
+    // the stack always has room for at least this one
+    minefield->reveal_stack.items[len++] = y * minefield->width + x;
+    while (len > 0 || overflowed) {
+        if (len == 0) {
+            overflowed = minefield_reveal_rescan(minefield, &len);
+            continue;
+        }
+        // big enough to be worth starting threads for; the first tile (the only one that can have
+        // mines around it) is always done by now
+        if (parallel && revealed >= PARALLEL_REVEAL_MIN_TILES) {
+            if (minefield_reveal_parallel(minefield, len)) {
+                len = 0;
+                continue;
+            }
+            parallel = false;
+        }
+        size_t offset = minefield->reveal_stack.items[--len];
+        x = offset % minefield->width;
+        y = offset / minefield->width;
+
+        size_t x_start = x > 0 ? x - 1 : 0;
+        size_t y_start = y > 0 ? y - 1 : 0;
+        // TODO: this is kinda ugly
+        size_t x_end = x < minefield->width - 1 ? x + 1 : x;
+        size_t y_end = y < minefield->height - 1 ? y + 1 : y;
         for (size_t y1 = y_start; y1 <= y_end; y1++) {
-            struct Tile *surtile = minefield_get_tile(minefield, x1, y1);
-            if (!surtile->visible && !surtile->flagged) {
-                no_mines &= minefield_reveal_tile(minefield, x1, y1);
+            for (size_t x1 = x_start; x1 <= x_end; x1++) {
+                struct Tile *surtile = minefield_get_tile(minefield, x1, y1);
+                if (tile_is_visible(surtile) || tile_is_flagged(surtile)) {
+                    continue;
+                }
+                // only possible for the first tile, since zeroes can't have mines around them
+                if (tile_is_mine(surtile)) {
+                    no_mines = false;
+                    continue;
+                }
+                minefield_record_change(minefield, x1, y1, surtile);
+                tile_set_visible(surtile);
+                minefield->visible_tiles++;
+                revealed++;
+                minefield_mark_dirty(minefield, x1, y1);
+                minefield_notify_revealed(minefield, x1, y1);
+                if (tile_surrounding(surtile) == 0 && !minefield_reveal_push(minefield, &len, y1 * minefield->width + x1)) {
+                    overflowed = true;
+                }
             }
         }
     }
     return no_mines;
 }
 
+size_t minefield_3bv(struct Minefield *minefield) {
+    if (minefield->openings.built) {
+        return minefield->openings.bv3;
+    }
+    size_t tiles_len = minefield->width * minefield->height;
+    // tiles a click on an opening would reveal, those don't need clicks of their own
+    uint8_t *covered = calloc(tiles_len, sizeof(uint8_t));
+    if (!covered) {
+        return SIZE_MAX;
+    }
+    size_t clicks = 0;
+    for (size_t start = 0; start < tiles_len; start++) {
+        struct Tile *tile = minefield_get_tile(minefield, start % minefield->width, start / minefield->width);
+        if (covered[start] || tile_is_mine(tile) || tile_surrounding(tile) != 0) {
+            continue;
+        }
+        // one click for the whole opening, flood filled the same way minefield_reveal_tile does
+        clicks++;
+        covered[start] = 1;
+        size_t len = 0;
+        minefield->reveal_stack.items[len++] = start;
+        while (len > 0) {
+            size_t offset = minefield->reveal_stack.items[--len];
+            size_t x = offset % minefield->width;
+            size_t y = offset / minefield->width;
+            size_t x_start = x > 0 ? x - 1 : 0;
+            size_t y_start = y > 0 ? y - 1 : 0;
+            size_t x_end = x < minefield->width - 1 ? x + 1 : x;
+            size_t y_end = y < minefield->height - 1 ? y + 1 : y;
+            for (size_t y1 = y_start; y1 <= y_end; y1++) {
+                for (size_t x1 = x_start; x1 <= x_end; x1++) {
+                    size_t offset1 = y1 * minefield->width + x1;
+                    if (covered[offset1]) {
+                        continue;
+                    }
+                    covered[offset1] = 1;
+                    if (tile_surrounding(minefield_get_tile(minefield, x1, y1)) == 0 &&
+                        !minefield_reveal_push(minefield, &len, offset1)) {
+                        free(covered);
+                        return SIZE_MAX;
+                    }
+                }
+            }
+        }
+    }
+    // every number that isn't next to an opening needs its own click
+    for (size_t offset = 0; offset < tiles_len; offset++) {
+        if (!covered[offset] && !tile_is_mine(minefield_get_tile(minefield, offset % minefield->width,
+                                                                  offset / minefield->width))) {
+            clicks++;
+        }
+    }
+    free(covered);
+    return clicks;
+}
+
 size_t minefield_count_surrounding_mines(struct Minefield *minefield, size_t x, size_t y) {
     size_t surrounding = 0;
 
     for (size_t x1 = x - 1; x1 <= x + 1; x1++) {
         for (size_t y1 = y - 1; y1 <= y + 1; y1++) {
             if ((x1 >= 0 && y1 >= 0) && (x1 < minefield->width && y1 < minefield->height)) { // make sure we are in bounds
-                if (minefield_get_tile(minefield, x1, y1)->mine) {
+                if (tile_is_mine(minefield_get_tile(minefield, x1, y1))) {
                     surrounding++;
                 }
             }
@@ -127,7 +1145,7 @@ size_t minefield_count_surrounding_flags(struct Minefield *minefield, size_t x,
     for (size_t x1 = x - 1; x1 <= x + 1; x1++) {
         for (size_t y1 = y - 1; y1 <= y + 1; y1++) {
             if ((x1 >= 0 && y1 >= 0) && (x1 < minefield->width && y1 < minefield->height)) { // make sure we are in bounds
-                if (minefield_get_tile(minefield, x1, y1)->flagged) {
+                if (tile_is_flagged(minefield_get_tile(minefield, x1, y1))) {
                     surrounding++;
                 }
             }
@@ -137,16 +1155,129 @@ size_t minefield_count_surrounding_flags(struct Minefield *minefield, size_t x,
     return surrounding;
 }
 
-bool minefield_check_victory(struct Minefield *minefield) {
-    /* TODO: count up the hidden tiles as they are revealed so they
-     * don't have to be recounted every time this function runs */
-    size_t hidden = 0;
-    for (size_t x = 0; x < minefield->width; x++) {
-        for (size_t y = 0; y < minefield->height; y++) {
-            if (!minefield_get_tile(minefield, x, y)->visible)
-                hidden++;
+void minefield_toggle_flag(struct Minefield *minefield, size_t x, size_t y) {
+    struct Tile *tile = minefield_get_tile(minefield, x, y);
+    if (tile_is_visible(tile)) {
+        return;
+    }
+    minefield_record_change(minefield, x, y, tile);
+    tile_toggle_flagged(tile);
+    minefield_mark_dirty(minefield, x, y);
+    if (tile_is_flagged(tile)) {
+        minefield->placed_flags++;
+        if (tile_is_mine(tile)) {
+            minefield->correct_flags++;
+        }
+    } else {
+        minefield->placed_flags--;
+        if (tile_is_mine(tile)) {
+            minefield->correct_flags--;
+        }
+    }
+}
+
+// put the bits of `*bits` that are in `mask` into a tile and its old bits into `*bits`
+static void minefield_swap_tile_bits(struct Minefield *minefield, size_t offset, uint8_t *bits, uint8_t mask) {
+    size_t x = offset % minefield->width;
+    size_t y = offset / minefield->width;
+    struct Tile *tile = minefield_get_tile(minefield, x, y);
+    struct Tile old = *tile;
+    struct Tile new = { (*bits & mask) | (old.bits & ~mask) };
+
+    minefield->visible_tiles += tile_is_visible(&new) - tile_is_visible(&old);
+    minefield->placed_flags += tile_is_flagged(&new) - tile_is_flagged(&old);
+    minefield->correct_flags += (tile_is_flagged(&new) && tile_is_mine(&new)) - (tile_is_flagged(&old) && tile_is_mine(&old));
+
+    // the dirty bit belongs to the dirty list, not to the tile's state
+    tile->bits = (new.bits & ~TILE_DIRTY_BIT) | (old.bits & TILE_DIRTY_BIT);
+    *bits = old.bits & ~TILE_DIRTY_BIT;
+    minefield_mark_dirty(minefield, x, y);
+    // the solver ignores flags, and a tile coming or going only changes what the numbers around it see,
+    // which is what solver_tile_revealed queues up either way. moving a mine changes what it found though,
+    // and a tile it found safe was dropped from its safe list once revealed, so hiding one needs a rescan
+    if (minefield->solver) {
+        uint8_t marks = TILE_VISIBLE_BIT | TILE_FLAGGED_BIT | TILE_DIRTY_BIT;
+        bool hidden = tile_is_visible(&old) && !tile_is_visible(&new);
+        if ((new.bits & ~marks) != (old.bits & ~marks) || (hidden && (minefield->solver->tiles[offset] & SOLVER_SAFE))) {
+            solver_reset(minefield->solver);
+        } else if (tile_is_visible(&new) != tile_is_visible(&old)) {
+            solver_tile_revealed(minefield->solver, offset);
         }
     }
+}
+
+void minefield_swap_tile_state(struct Minefield *minefield, size_t offset, uint8_t *bits) {
+    minefield_swap_tile_bits(minefield, offset, bits, (uint8_t)~TILE_DIRTY_BIT);
+}
 
+void minefield_swap_tile_marks(struct Minefield *minefield, size_t offset, uint8_t *bits) {
+    minefield_swap_tile_bits(minefield, offset, bits, TILE_VISIBLE_BIT | TILE_FLAGGED_BIT);
+}
+
+void minefield_reveal_mines(struct Minefield *minefield) {
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (tile_is_mine(tile) && !tile_is_visible(tile)) {
+                minefield_record_change(minefield, x, y, tile);
+                tile_set_visible(tile);
+                minefield->visible_tiles++;
+                minefield_mark_dirty(minefield, x, y);
+                minefield_notify_revealed(minefield, x, y);
+            }
+        }
+    }
+}
+
+void minefield_reveal_all(struct Minefield *minefield) {
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (!tile_is_visible(tile)) {
+                minefield_record_change(minefield, x, y, tile);
+                tile_set_visible(tile);
+            }
+        }
+    }
+    minefield->visible_tiles = minefield->width * minefield->height;
+    minefield_mark_all_dirty(minefield);
+    if (minefield->solver) {
+        solver_reset(minefield->solver);
+    }
+}
+
+// recount everything the slow way and make sure the running counters agree
+// a pass over the whole board on every move, so it's only checked when MINEFIELD_CHECK_COUNTERS is
+// defined instead of in every build that keeps asserts
+#ifdef MINEFIELD_CHECK_COUNTERS
+static bool minefield_counters_consistent(struct Minefield *minefield) {
+    size_t visible = 0;
+    size_t placed = 0;
+    size_t correct = 0;
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (tile_is_visible(tile)) {
+                visible++;
+            }
+            if (tile_is_flagged(tile)) {
+                placed++;
+                if (tile_is_mine(tile)) {
+                    correct++;
+                }
+            }
+        }
+    }
+    return visible == minefield->visible_tiles &&
+           placed == minefield->placed_flags &&
+           correct == minefield->correct_flags;
+}
+#endif
+
+bool minefield_check_victory(struct Minefield *minefield) {
+#ifdef MINEFIELD_CHECK_COUNTERS
+    assert(minefield_counters_consistent(minefield));
+#endif
+    size_t hidden = minefield->width * minefield->height - minefield->visible_tiles;
     return hidden == minefield->mines;
 }
@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L // sysconf
+
+#include "noguess.h"
+
+#include "bitboard.h"
+#include "minefield.h"
+#include "rng.h"
+#include "solver.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define NOGUESS_MAX_THREADS 64
+
+struct NoguessPool {
+    struct Minefield *target; // only read from while the workers run
+    size_t next; // next candidate to check, taken with __atomic_fetch_add
+    size_t best; // lowest candidate that worked so far, SIZE_MAX if none
+    bool failed; // out of memory somewhere, so best can't be trusted to be the lowest
+};
+
+// everything a thread needs to play out candidates on its own
+struct NoguessWorker {
+    struct NoguessPool *pool;
+    struct Bitboard board;
+    struct Minefield minefield;
+    struct Solver solver;
+};
+
+// play a candidate out with the solver, true if it gets to the end without a guess
+static bool noguess_check(struct NoguessWorker *worker, uint64_t seed, bool *out_of_memory) {
+    struct Minefield *target = worker->pool->target;
+    struct Minefield *minefield = &worker->minefield;
+    struct Solver *solver = &worker->solver;
+    // small boards get as far as they can on the bitboard first, most of them are decided there
+    bool small = bitboard_fits(target->width, target->height);
+    if (small) {
+        struct Bitboard *board = &worker->board;
+        bitboard_init(board, target->width, target->height, target->mines);
+        bitboard_populate(board, seed, target->cur.x, target->cur.y);
+        bitboard_reveal(board, target->cur.x, target->cur.y);
+        bitboard_solve(board);
+        if (bitboard_check_victory(board)) {
+            return true;
+        }
+    }
+
+    minefield->solver = NULL;
+    if (!minefield_init(minefield, target->width, target->height, target->mines, seed)) {
+        *out_of_memory = true;
+        return false;
+    }
+    minefield->cur.x = target->cur.x;
+    minefield->cur.y = target->cur.y;
+    if (small) {
+        // stuck without the subset deductions, so the full solver takes over from where the bitboard is
+        bitboard_store(&worker->board, minefield);
+    } else {
+        minefield_populate(minefield);
+    }
+    if (!solver_init(solver, minefield)) {
+        *out_of_memory = true;
+        return false;
+    }
+    minefield->solver = solver;
+    if (small) {
+        solver_reset(solver);
+    } else {
+        minefield_reveal_tile(minefield, minefield->cur.x, minefield->cur.y);
+    }
+
+    size_t goal = minefield->width * minefield->height - minefield->mines;
+    while (minefield->visible_tiles < goal) {
+        solver_solve(solver);
+        bool progress = false;
+        for (size_t i = 0; i < solver->safe.len; i++) {
+            size_t x = solver->safe.items[i] % minefield->width;
+            size_t y = solver->safe.items[i] / minefield->width;
+            if (!tile_is_visible(minefield_get_tile(minefield, x, y))) {
+                minefield_reveal_tile(minefield, x, y); // can't be a mine, the solver is never wrong
+                progress = true;
+            }
+        }
+        // all of them are visible now
+        solver->safe.len = 0;
+        if (!progress) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *noguess_worker_run(void *arg) {
+    struct NoguessWorker *worker = arg;
+    struct NoguessPool *pool = worker->pool;
+    for (;;) {
+        size_t i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        // anything past the best so far can't win anymore
+        if (i >= NOGUESS_MAX_CANDIDATES || i >= __atomic_load_n(&pool->best, __ATOMIC_RELAXED)) {
+            return NULL;
+        }
+        bool out_of_memory = false;
+        if (noguess_check(worker, rng_derive_seed(pool->target->seed, i), &out_of_memory)) {
+            size_t best = __atomic_load_n(&pool->best, __ATOMIC_RELAXED);
+            while (i < best && !__atomic_compare_exchange_n(&pool->best, &best, i, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                // someone else changed best in the meantime, compare against what it is now
+            }
+        } else if (out_of_memory) {
+            // the candidate that should have won might be the one that couldn't be checked
+            __atomic_store_n(&pool->failed, true, __ATOMIC_RELAXED);
+            return NULL;
+        }
+    }
+}
+
+bool noguess_populate(struct Minefield *minefield, int threads) {
+    if (threads < 1) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus < 1 ? 1 : cpus;
+    }
+    threads = threads > NOGUESS_MAX_THREADS ? NOGUESS_MAX_THREADS : threads;
+
+    struct NoguessPool pool = { .target = minefield, .next = 0, .best = SIZE_MAX, .failed = false };
+    struct NoguessWorker *workers = calloc(threads, sizeof(struct NoguessWorker));
+    pool.failed = !workers;
+    if (workers) {
+        pthread_t ids[NOGUESS_MAX_THREADS];
+        int started = 0;
+        for (int i = 0; i < threads; i++) {
+            workers[i].pool = &pool;
+        }
+        for (int i = 1; i < threads; i++) {
+            if (pthread_create(&ids[started], NULL, noguess_worker_run, &workers[started + 1]) == 0) {
+                started++;
+            }
+        }
+        noguess_worker_run(&workers[0]);
+        for (int i = 0; i < started; i++) {
+            pthread_join(ids[i], NULL);
+        }
+        for (int i = 0; i < threads; i++) {
+            minefield_cleanup(&workers[i].minefield);
+            solver_cleanup(&workers[i].solver);
+        }
+        free(workers);
+    }
+
+    // the winner is made again here, it's cheaper than copying a whole board out of a worker
+    bool found = pool.best != SIZE_MAX && !pool.failed;
+    uint64_t seed = minefield->seed;
+    minefield->seed = found ? rng_derive_seed(seed, pool.best) : seed;
+    minefield_populate(minefield);
+    // the seed shown to the player has to give the same board again with --no-guess
+    minefield->seed = seed;
+    return found;
+}
@@ -0,0 +1,189 @@
+#include "pregen.h"
+
+#include "game.h"
+#include "minefield.h"
+#include "noguess.h"
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct PregenWorker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    // guarded by lock
+    bool busy; // making the board for seed
+    bool ready; // board is done and populated for seed
+    bool quit; // nobody's waiting for boards anymore, free everything once not busy
+    uint64_t seed;
+    // only touched by the worker while busy, and by pregen_next_game while not
+    size_t width, height, mines;
+    bool no_guess;
+    struct Minefield board;
+    uint8_t *solver_tiles; // width * height zeroes for the next game's solver
+};
+
+// clear the board and populate it for a first click in the middle
+static bool pregen_make(struct PregenWorker *worker, uint64_t seed) {
+    struct Minefield *board = &worker->board;
+    if (!minefield_init(board, worker->width, worker->height, worker->mines, seed)) {
+        return false;
+    }
+    if (worker->no_guess) {
+        // this runs while the current game is played, so it only gets one core; the synchronous
+        // fallback in pregen_populate still uses all of them
+        noguess_populate(board, 1);
+    } else {
+        minefield_populate(board);
+    }
+    size_t tiles = worker->width * worker->height;
+    if (worker->solver_tiles) {
+        memset(worker->solver_tiles, 0, tiles);
+    } else {
+        worker->solver_tiles = calloc(tiles, sizeof(uint8_t));
+    }
+    return worker->solver_tiles != NULL;
+}
+
+static void *pregen_worker_run(void *arg) {
+    struct PregenWorker *worker = arg;
+    pthread_mutex_lock(&worker->lock);
+    while (true) {
+        while (!worker->busy && !worker->quit) {
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+        if (!worker->busy) {
+            break;
+        }
+        uint64_t seed = worker->seed;
+        pthread_mutex_unlock(&worker->lock);
+        bool ready = pregen_make(worker, seed);
+        pthread_mutex_lock(&worker->lock);
+        worker->ready = ready;
+        worker->busy = false;
+        pthread_cond_broadcast(&worker->cond);
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    minefield_cleanup(&worker->board);
+    free(worker->solver_tiles);
+    pthread_mutex_destroy(&worker->lock);
+    pthread_cond_destroy(&worker->cond);
+    free(worker);
+    return NULL;
+}
+
+// with the lock held
+static void pregen_wait_idle(struct PregenWorker *worker) {
+    while (worker->busy) {
+        pthread_cond_wait(&worker->cond, &worker->lock);
+    }
+}
+
+bool pregen_init(struct Pregen *pregen, struct Game *game, bool no_guess) {
+    pregen->width = game->minefield.width;
+    pregen->height = game->minefield.height;
+    pregen->mines = game->minefield.mines;
+    pregen->no_guess = no_guess;
+    pregen->populated = false;
+    pregen->openings_built = false;
+
+    struct PregenWorker *worker = calloc(1, sizeof(struct PregenWorker));
+    if (!worker) {
+        pregen->worker = NULL;
+        return false;
+    }
+    worker->width = pregen->width;
+    worker->height = pregen->height;
+    worker->mines = pregen->mines;
+    worker->no_guess = no_guess;
+    worker->board.block_shift = game->minefield.block_shift;
+    worker->board.reveal_threads = game->minefield.reveal_threads;
+    worker->board.index_openings = game->minefield.index_openings;
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    if (pthread_create(&worker->thread, NULL, pregen_worker_run, worker) != 0) {
+        pthread_mutex_destroy(&worker->lock);
+        pthread_cond_destroy(&worker->cond);
+        free(worker);
+        pregen->worker = NULL;
+        return false;
+    }
+    pregen->worker = worker;
+    return true;
+}
+
+void pregen_cleanup(struct Pregen *pregen) {
+    struct PregenWorker *worker = pregen->worker;
+    if (!worker) {
+        return;
+    }
+    pthread_mutex_lock(&worker->lock);
+    worker->quit = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_detach(worker->thread);
+    pthread_mutex_unlock(&worker->lock);
+    pregen->worker = NULL;
+}
+
+void pregen_prepare(struct Pregen *pregen, uint64_t seed) {
+    struct PregenWorker *worker = pregen->worker;
+    if (!worker) {
+        return;
+    }
+    pthread_mutex_lock(&worker->lock);
+    pregen_wait_idle(worker);
+    worker->seed = seed;
+    worker->ready = false;
+    worker->busy = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+void pregen_next_game(struct Pregen *pregen, struct Game *game, uint64_t seed, size_t undo_bytes) {
+    struct PregenWorker *worker = pregen->worker;
+    bool ready = false;
+    if (worker) {
+        pthread_mutex_lock(&worker->lock);
+        pregen_wait_idle(worker);
+        ready = worker->ready && worker->seed == seed;
+        worker->ready = false;
+        pthread_mutex_unlock(&worker->lock);
+    }
+    if (!ready) {
+        game_init(game, pregen->width, pregen->height, pregen->mines, seed, undo_bytes);
+        pregen->populated = false;
+        return;
+    }
+    game_init_swap(game, &worker->board, &worker->solver_tiles, undo_bytes);
+    pregen->populated = true;
+    pregen->openings_built = game->minefield.openings.built;
+    game->minefield.openings.built = false;
+}
+
+void pregen_populate(struct Pregen *pregen, struct Game *game) {
+    struct Minefield *minefield = &game->minefield;
+    if (pregen->populated) {
+        pregen->populated = false;
+        if (minefield->cur.x == (int)(minefield->width / 2) && minefield->cur.y == (int)(minefield->height / 2)) {
+            minefield->openings.built = pregen->openings_built;
+            return;
+        }
+        // the first click is somewhere else, so the mines go somewhere else too; flags stay where they are
+        size_t tiles_len = minefield_tiles_len(minefield);
+        for (size_t i = 0; i < tiles_len; i++) {
+            minefield->tiles[i].bits &= TILE_FLAGGED_BIT | TILE_DIRTY_BIT;
+        }
+    }
+    if (pregen->no_guess) {
+        // falls back to an ordinary board if none of the candidates work
+        noguess_populate(minefield, 0);
+    } else {
+        minefield_populate(minefield);
+    }
+}
@@ -0,0 +1,918 @@
+#define _POSIX_C_SOURCE 200809L // sysconf
+
+#include "probability.h"
+
+#include "minefield.h"
+#include "solver.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// past this many tiles, a component is estimated instead of enumerated
+static const size_t MAX_COMPONENT_VARS = 128;
+// same if enumerating it takes more than this many steps
+static const uint64_t MAX_COMPONENT_STEPS = 1 << 24;
+// combining components exactly takes about (components * frontier tiles^2) steps, past this they're estimated
+static const double MAX_COMBINE_STEPS = 2e8;
+// the memo is emptied after a probability_compute that left it holding more than this
+static const size_t MAX_MEMO_BYTES = 64 << 20;
+// components smaller than this are enumerated on the calling thread, starting a thread costs more
+static const size_t MIN_THREADED_VARS = 24;
+#define PROBABILITY_MAX_THREADS 64
+
+// a visible number and the frontier tiles around it
+struct Constraint {
+    size_t tile;
+    uint32_t vars[8]; // indexes into scratch.vars
+    uint8_t len;
+    uint8_t need; // mines left around the number, after the ones the solver found
+};
+
+// how many mine layouts a component has, by how many mines they use
+struct ComponentResult {
+    size_t len; // tiles in the component
+    double *counts; // [len + 1]: layouts with k mines
+    double *var_counts; // [len * (len + 1)]: layouts with k mines where tile i is a mine, at [i * (len + 1) + k]
+    bool exact; // false if it was too big to enumerate, counts are NULL then
+};
+
+struct Component {
+    size_t var_start, len; // into scratch.order
+    size_t con_start, con_len; // into scratch.component_cons
+    uint64_t hash;
+    size_t *signature; // everything the result depends on, to tell memo entries apart
+    size_t signature_len;
+    struct ComponentResult result;
+    bool from_memo; // result belongs to the memo, don't free it
+};
+
+struct MemoEntry {
+    uint64_t hash;
+    size_t *signature; // NULL if the slot is empty
+    size_t signature_len;
+    struct ComponentResult result;
+};
+struct ProbabilityMemo {
+    struct MemoEntry *entries;
+    size_t cap; // power of 2
+    size_t len;
+    size_t bytes;
+};
+
+// per-probability_compute buffers
+struct Scratch {
+    uint32_t *var_of; // for every tile, its index in vars + 1, or 0
+    size_t *vars; // frontier tiles
+    size_t vars_len, vars_cap;
+    struct Constraint *cons;
+    size_t cons_len, cons_cap;
+    uint32_t *parent; // union-find over vars
+    size_t *order; // vars grouped by component
+    size_t *component_cons; // constraint indexes grouped by component
+    struct Component *components;
+    size_t components_len;
+};
+
+static bool probability_grow(void **items, size_t *cap, size_t len, size_t size) {
+    if (len < *cap) {
+        return true;
+    }
+    size_t new_cap = *cap ? *cap * 2 : 64;
+    void *new_items = realloc(*items, new_cap * size);
+    if (!new_items) {
+        return false;
+    }
+    *items = new_items;
+    *cap = new_cap;
+    return true;
+}
+
+static void result_free(struct ComponentResult *result) {
+    free(result->counts);
+    free(result->var_counts);
+    result->counts = result->var_counts = NULL;
+}
+
+static void memo_clear(struct ProbabilityMemo *memo) {
+    for (size_t i = 0; i < memo->cap; i++) {
+        if (memo->entries[i].signature) {
+            free(memo->entries[i].signature);
+            result_free(&memo->entries[i].result);
+            memo->entries[i].signature = NULL;
+        }
+    }
+    memo->len = 0;
+    memo->bytes = 0;
+}
+
+void probability_init(struct Probability *probability, struct Minefield *minefield, struct Solver *solver) {
+    probability->minefield = minefield;
+    probability->solver = solver;
+    free(probability->tiles);
+    probability->tiles = NULL;
+    probability->tiles_len = 0;
+    probability->outside = 0;
+    probability->exact = true;
+    probability->generation++;
+    // makes probability_stale true until the first probability_compute
+    probability->solver_revision = solver->revision - 1;
+    if (probability->threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        probability->threads = cpus < 1 ? 1 : cpus > PROBABILITY_MAX_THREADS ? PROBABILITY_MAX_THREADS : cpus;
+    }
+    // a new board makes everything in the memo useless
+    if (probability->memo) {
+        memo_clear(probability->memo);
+    }
+}
+
+void probability_cleanup(struct Probability *probability) {
+    free(probability->tiles);
+    probability->tiles = NULL;
+    probability->tiles_len = 0;
+    if (probability->memo) {
+        memo_clear(probability->memo);
+        free(probability->memo->entries);
+        free(probability->memo);
+        probability->memo = NULL;
+    }
+}
+
+bool probability_stale(struct Probability *probability) {
+    return !probability->tiles || probability->solver_revision != probability->solver->revision;
+}
+
+static uint32_t union_find(uint32_t *parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]]; // path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+// find the frontier tiles and the numbers around them, returns false if out of memory
+// *outside is how many hidden unknown tiles no number touches, *known_mines how many mines the solver found
+static bool collect_frontier(struct Probability *probability, struct Scratch *scratch, size_t *outside, size_t *known_mines) {
+    struct Minefield *minefield = probability->minefield;
+    uint8_t *known = probability->solver->tiles;
+    *outside = 0;
+    *known_mines = 0;
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            size_t offset = y * minefield->width + x;
+            struct Tile *tile = minefield_get_tile(minefield, x, y);
+            if (!tile_is_visible(tile)) {
+                if (known[offset] & SOLVER_MINE) {
+                    (*known_mines)++;
+                } else if (!(known[offset] & SOLVER_SAFE) && !scratch->var_of[offset]) {
+                    (*outside)++; // taken back below if a number turns up next to it
+                }
+                continue;
+            }
+            if (tile_is_mine(tile) || tile_surrounding(tile) == 0) {
+                continue;
+            }
+            struct Constraint con = { .tile = offset, .len = 0 };
+            size_t mines = 0;
+            size_t x_start = x > 0 ? x - 1 : 0;
+            size_t y_start = y > 0 ? y - 1 : 0;
+            size_t x_end = x < minefield->width - 1 ? x + 1 : x;
+            size_t y_end = y < minefield->height - 1 ? y + 1 : y;
+            for (size_t y1 = y_start; y1 <= y_end; y1++) {
+                for (size_t x1 = x_start; x1 <= x_end; x1++) {
+                    size_t offset1 = y1 * minefield->width + x1;
+                    if (tile_is_visible(minefield_get_tile(minefield, x1, y1))) {
+                        continue;
+                    }
+                    if (known[offset1] & SOLVER_MINE) {
+                        mines++;
+                        continue;
+                    }
+                    if (known[offset1] & SOLVER_SAFE) {
+                        continue;
+                    }
+                    if (!scratch->var_of[offset1]) {
+                        if (!probability_grow((void **)&scratch->vars, &scratch->vars_cap, scratch->vars_len, sizeof(size_t))) {
+                            return false;
+                        }
+                        scratch->vars[scratch->vars_len++] = offset1;
+                        scratch->var_of[offset1] = scratch->vars_len;
+                        // already counted as outside if the scan went past it
+                        if (offset1 < offset) {
+                            (*outside)--;
+                        }
+                    }
+                    con.vars[con.len++] = scratch->var_of[offset1] - 1;
+                }
+            }
+            if (con.len == 0) {
+                continue;
+            }
+            con.need = tile_surrounding(tile) - mines;
+            if (!probability_grow((void **)&scratch->cons, &scratch->cons_cap, scratch->cons_len, sizeof(struct Constraint))) {
+                return false;
+            }
+            scratch->cons[scratch->cons_len++] = con;
+        }
+    }
+    return true;
+}
+
+// group the frontier into components of tiles that share numbers, returns false if out of memory
+static bool split_components(struct Scratch *scratch) {
+    size_t vars_len = scratch->vars_len;
+    scratch->parent = malloc(vars_len * sizeof(uint32_t) + 1);
+    scratch->order = malloc(vars_len * sizeof(size_t) + 1);
+    scratch->component_cons = malloc(scratch->cons_len * sizeof(size_t) + 1);
+    size_t *component_of = malloc(vars_len * sizeof(size_t) + 1); // by root, index into components + 1
+    size_t *placed = calloc(vars_len + 1, sizeof(size_t)); // per var, position in order + 1
+    scratch->components = calloc(vars_len + 1, sizeof(struct Component));
+    if (!scratch->parent || !scratch->order || !scratch->component_cons || !component_of || !placed || !scratch->components) {
+        free(component_of);
+        free(placed);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < vars_len; i++) {
+        scratch->parent[i] = i;
+        component_of[i] = 0;
+    }
+    for (size_t i = 0; i < scratch->cons_len; i++) {
+        struct Constraint *con = &scratch->cons[i];
+        uint32_t root = union_find(scratch->parent, con->vars[0]);
+        for (size_t j = 1; j < con->len; j++) {
+            uint32_t other = union_find(scratch->parent, con->vars[j]);
+            if (other != root) {
+                scratch->parent[other] = root;
+            }
+        }
+    }
+
+    // count tiles and numbers per component, in the order the numbers were found
+    scratch->components_len = 0;
+    for (size_t i = 0; i < scratch->cons_len; i++) {
+        uint32_t root = union_find(scratch->parent, scratch->cons[i].vars[0]);
+        if (!component_of[root]) {
+            component_of[root] = ++scratch->components_len;
+        }
+        scratch->components[component_of[root] - 1].con_len++;
+    }
+    for (size_t i = 0; i < vars_len; i++) {
+        scratch->components[component_of[union_find(scratch->parent, i)] - 1].len++;
+    }
+    size_t var_start = 0, con_start = 0;
+    for (size_t i = 0; i < scratch->components_len; i++) {
+        struct Component *component = &scratch->components[i];
+        component->var_start = var_start;
+        component->con_start = con_start;
+        var_start += component->len;
+        con_start += component->con_len;
+        component->len = 0;
+        component->con_len = 0;
+    }
+    // tiles are ordered by the first number that touches them, so backtracking can check
+    // each number as soon as possible
+    for (size_t i = 0; i < scratch->cons_len; i++) {
+        struct Constraint *con = &scratch->cons[i];
+        struct Component *component = &scratch->components[component_of[union_find(scratch->parent, con->vars[0])] - 1];
+        scratch->component_cons[component->con_start + component->con_len++] = i;
+        for (size_t j = 0; j < con->len; j++) {
+            if (!placed[con->vars[j]]) {
+                placed[con->vars[j]] = 1;
+                scratch->order[component->var_start + component->len++] = con->vars[j];
+            }
+        }
+    }
+    free(component_of);
+    free(placed);
+    return true;
+}
+
+// the numbers and tiles of a component in order; two components with the same signature have the same result
+static bool component_signature(struct Scratch *scratch, struct Component *component) {
+    size_t len = 0;
+    for (size_t i = 0; i < component->con_len; i++) {
+        len += 3 + scratch->cons[scratch->component_cons[component->con_start + i]].len;
+    }
+    component->signature = malloc(len * sizeof(size_t));
+    if (!component->signature) {
+        return false;
+    }
+    uint64_t hash = 0xcbf29ce484222325; // FNV-1a over the words
+    size_t n = 0;
+    for (size_t i = 0; i < component->con_len; i++) {
+        struct Constraint *con = &scratch->cons[scratch->component_cons[component->con_start + i]];
+        component->signature[n++] = con->tile;
+        component->signature[n++] = con->need;
+        component->signature[n++] = con->len;
+        for (size_t j = 0; j < con->len; j++) {
+            component->signature[n++] = scratch->vars[con->vars[j]];
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        hash = (hash ^ component->signature[i]) * 0x100000001b3;
+    }
+    component->signature_len = n;
+    component->hash = hash;
+    return true;
+}
+
+static struct MemoEntry *memo_find(struct ProbabilityMemo *memo, struct Component *component) {
+    if (!memo || memo->cap == 0) {
+        return NULL;
+    }
+    for (size_t i = component->hash & (memo->cap - 1);; i = (i + 1) & (memo->cap - 1)) {
+        struct MemoEntry *entry = &memo->entries[i];
+        if (!entry->signature) {
+            return NULL;
+        }
+        if (entry->hash == component->hash && entry->signature_len == component->signature_len &&
+            memcmp(entry->signature, component->signature, component->signature_len * sizeof(size_t)) == 0) {
+            return entry;
+        }
+    }
+}
+
+// hand a component's result and signature over to the memo, returns false if out of memory
+static bool memo_insert(struct Probability *probability, struct Component *component) {
+    if (!probability->memo) {
+        probability->memo = calloc(1, sizeof(struct ProbabilityMemo));
+        if (!probability->memo) {
+            return false;
+        }
+    }
+    struct ProbabilityMemo *memo = probability->memo;
+    size_t len = component->result.len;
+    size_t bytes = component->signature_len * sizeof(size_t) + (len + 1) * (len + 1) * sizeof(double);
+    // keep it at most half full
+    if ((memo->len + 1) * 2 > memo->cap) {
+        size_t cap = memo->cap ? memo->cap * 2 : 256;
+        struct MemoEntry *entries = calloc(cap, sizeof(struct MemoEntry));
+        if (!entries) {
+            return false;
+        }
+        for (size_t i = 0; i < memo->cap; i++) {
+            if (!memo->entries[i].signature) {
+                continue;
+            }
+            size_t j = memo->entries[i].hash & (cap - 1);
+            while (entries[j].signature) {
+                j = (j + 1) & (cap - 1);
+            }
+            entries[j] = memo->entries[i];
+        }
+        free(memo->entries);
+        memo->entries = entries;
+        memo->cap = cap;
+    }
+    size_t i = component->hash & (memo->cap - 1);
+    while (memo->entries[i].signature) {
+        i = (i + 1) & (memo->cap - 1);
+    }
+    memo->entries[i] = (struct MemoEntry){
+        .hash = component->hash,
+        .signature = component->signature,
+        .signature_len = component->signature_len,
+        .result = component->result,
+    };
+    memo->len++;
+    memo->bytes += bytes;
+    component->signature = NULL;
+    component->from_memo = true;
+    return true;
+}
+
+// backtracking over one component's tiles
+struct Enumeration {
+    size_t len;
+    uint16_t (*var_cons)[8]; // per tile, which of the component's numbers touch it (indexes within the component)
+    uint8_t *var_cons_len;
+    uint8_t *need, *have, *left; // per number: mines it needs, mines placed, tiles not decided yet
+    size_t *mines; // tiles that are mines in the current layout
+    size_t mines_len;
+    uint64_t steps;
+    struct ComponentResult *result;
+};
+
+// returns false if it took too many steps
+static bool enumerate(struct Enumeration *e, size_t i) {
+    if (++e->steps > MAX_COMPONENT_STEPS) {
+        return false;
+    }
+    if (i == e->len) {
+        size_t k = e->mines_len;
+        e->result->counts[k] += 1;
+        for (size_t j = 0; j < k; j++) {
+            e->result->var_counts[e->mines[j] * (e->len + 1) + k] += 1;
+        }
+        e->steps += k;
+        return true;
+    }
+    for (uint8_t mine = 0; mine <= 1; mine++) {
+        bool ok = true;
+        for (size_t j = 0; j < e->var_cons_len[i]; j++) {
+            uint16_t c = e->var_cons[i][j];
+            e->have[c] += mine;
+            e->left[c]--;
+            if (e->have[c] > e->need[c] || e->have[c] + e->left[c] < e->need[c]) {
+                ok = false;
+            }
+        }
+        if (ok) {
+            if (mine) {
+                e->mines[e->mines_len++] = i;
+            }
+            bool finished = enumerate(e, i + 1);
+            if (mine) {
+                e->mines_len--;
+            }
+            if (!finished) {
+                return false;
+            }
+        }
+        for (size_t j = 0; j < e->var_cons_len[i]; j++) {
+            uint16_t c = e->var_cons[i][j];
+            e->have[c] -= mine;
+            e->left[c]++;
+        }
+    }
+    return true;
+}
+
+// count every mine layout of a component; result.exact is false if it was too big (or out of memory)
+static void component_enumerate(struct Scratch *scratch, struct Component *component) {
+    struct ComponentResult *result = &component->result;
+    size_t len = component->len;
+    result->len = len;
+    result->exact = false;
+    if (len > MAX_COMPONENT_VARS) {
+        return;
+    }
+    result->counts = calloc(len + 1, sizeof(double));
+    result->var_counts = calloc(len * (len + 1), sizeof(double));
+    struct Enumeration e = {
+        .len = len,
+        .var_cons = calloc(len, sizeof(*e.var_cons)),
+        .var_cons_len = calloc(len, sizeof(uint8_t)),
+        .need = malloc(component->con_len),
+        .have = calloc(component->con_len, 1),
+        .left = calloc(component->con_len, 1),
+        .mines = malloc(len * sizeof(size_t)),
+        .result = result,
+    };
+    bool ok = result->counts && result->var_counts && e.var_cons && e.var_cons_len && e.need && e.have && e.left && e.mines;
+    if (ok) {
+        // var_of is reused for the tiles' indexes within the component, nothing else looks at these tiles
+        for (size_t i = 0; i < len; i++) {
+            scratch->var_of[scratch->vars[scratch->order[component->var_start + i]]] = i + 1;
+        }
+        for (size_t c = 0; c < component->con_len; c++) {
+            struct Constraint *con = &scratch->cons[scratch->component_cons[component->con_start + c]];
+            e.need[c] = con->need;
+            e.left[c] = con->len;
+            for (size_t j = 0; j < con->len; j++) {
+                size_t i = scratch->var_of[scratch->vars[con->vars[j]]] - 1;
+                e.var_cons[i][e.var_cons_len[i]++] = c;
+            }
+        }
+        ok = enumerate(&e, 0);
+    }
+    free(e.var_cons);
+    free(e.var_cons_len);
+    free(e.need);
+    free(e.have);
+    free(e.left);
+    free(e.mines);
+    if (!ok) {
+        result_free(result);
+        return;
+    }
+    // only ratios matter, keep the numbers in range for combining
+    double max = 0;
+    for (size_t k = 0; k <= len; k++) {
+        max = result->counts[k] > max ? result->counts[k] : max;
+    }
+    for (size_t k = 0; k <= len; k++) {
+        result->counts[k] /= max;
+    }
+    for (size_t i = 0; i < len * (len + 1); i++) {
+        result->var_counts[i] /= max;
+    }
+    result->exact = true;
+}
+
+struct Worker {
+    struct Scratch *scratch;
+    struct Component **todo;
+    size_t todo_len;
+    size_t next; // shared, taken with __atomic_fetch_add
+};
+
+static void *worker_run(void *arg) {
+    struct Worker *worker = arg;
+    for (;;) {
+        size_t i = __atomic_fetch_add(&worker->next, 1, __ATOMIC_RELAXED);
+        if (i >= worker->todo_len) {
+            return NULL;
+        }
+        component_enumerate(worker->scratch, worker->todo[i]);
+    }
+}
+
+// enumerate every component that isn't in the memo, spread over threads if it's worth it
+static bool enumerate_components(struct Probability *probability, struct Scratch *scratch) {
+    struct Component **todo = malloc(scratch->components_len * sizeof(struct Component *) + 1);
+    if (!todo) {
+        return false;
+    }
+    size_t todo_len = 0;
+    size_t big = 0;
+    for (size_t i = 0; i < scratch->components_len; i++) {
+        struct Component *component = &scratch->components[i];
+        if (!component_signature(scratch, component)) {
+            free(todo);
+            return false;
+        }
+        struct MemoEntry *entry = memo_find(probability->memo, component);
+        if (entry) {
+            component->result = entry->result;
+            component->from_memo = true;
+            continue;
+        }
+        todo[todo_len++] = component;
+        if (component->len >= MIN_THREADED_VARS) {
+            big++;
+        }
+    }
+
+    struct Worker worker = { scratch, todo, todo_len, 0 };
+    int threads = big < (size_t)probability->threads ? (int)big : probability->threads;
+    pthread_t ids[PROBABILITY_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&ids[started], NULL, worker_run, &worker) == 0) {
+            started++;
+        }
+    }
+    worker_run(&worker);
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+
+    for (size_t i = 0; i < todo_len; i++) {
+        // estimated ones aren't worth remembering, they're cheap to give up on again
+        if (todo[i]->result.exact) {
+            memo_insert(probability, todo[i]);
+        }
+    }
+    free(todo);
+    return true;
+}
+
+static double log_choose(double n, double k) {
+    return lgamma(n + 1) - lgamma(k + 1) - lgamma(n - k + 1);
+}
+
+// c = a * b as polynomials, scaled so the biggest coefficient is 1
+static void convolve(const double *a, size_t a_len, const double *b, size_t b_len, double *c) {
+    size_t c_len = a_len + b_len - 1;
+    for (size_t i = 0; i < c_len; i++) {
+        c[i] = 0;
+    }
+    for (size_t i = 0; i < a_len; i++) {
+        if (a[i] == 0) {
+            continue;
+        }
+        for (size_t j = 0; j < b_len; j++) {
+            c[i + j] += a[i] * b[j];
+        }
+    }
+    double max = 0;
+    for (size_t i = 0; i < c_len; i++) {
+        max = c[i] > max ? c[i] : max;
+    }
+    if (max > 0) {
+        for (size_t i = 0; i < c_len; i++) {
+            c[i] /= max;
+        }
+    }
+}
+
+// chance of each of a component's tiles being a mine, with weight[k] how likely the rest of the board
+// makes it for the component to hold k mines
+static void component_probabilities(struct Probability *probability, struct Scratch *scratch, struct Component *component, const double *weight) {
+    struct ComponentResult *result = &component->result;
+    size_t len = result->len;
+    double total = 0;
+    for (size_t k = 0; k <= len; k++) {
+        total += result->counts[k] * weight[k];
+    }
+    for (size_t i = 0; i < len; i++) {
+        double mine = 0;
+        for (size_t k = 0; k <= len; k++) {
+            mine += result->var_counts[i * (len + 1) + k] * weight[k];
+        }
+        size_t tile = scratch->vars[scratch->order[component->var_start + i]];
+        probability->tiles[tile] = total > 0 ? mine / total : 0;
+    }
+}
+
+// combine the components assuming the remaining mines are spread evenly, so they don't affect each other
+static float combine_independent(struct Probability *probability, struct Scratch *scratch, size_t mines, size_t outside) {
+    // first guess at the density, then once more with what the components expect to hold
+    double density = outside + scratch->vars_len > 0 ? (double)mines / (outside + scratch->vars_len) : 0;
+    double *weight = malloc((MAX_COMPONENT_VARS + 1) * sizeof(double));
+    if (!weight) {
+        return density;
+    }
+    double expected = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        // keep the log below finite, a density of exactly 0 or 1 only allows layouts with no/all mines anyway
+        density = density < 1e-9 ? 1e-9 : density > 1 - 1e-9 ? 1 - 1e-9 : density;
+        double log_ratio = log(density / (1 - density));
+        expected = 0;
+        for (size_t i = 0; i < scratch->components_len; i++) {
+            struct Component *component = &scratch->components[i];
+            if (!component->result.exact) {
+                continue;
+            }
+            size_t len = component->result.len;
+            double max = -INFINITY;
+            for (size_t k = 0; k <= len; k++) {
+                max = k * log_ratio > max ? k * log_ratio : max;
+            }
+            for (size_t k = 0; k <= len; k++) {
+                weight[k] = exp(k * log_ratio - max);
+            }
+            component_probabilities(probability, scratch, component, weight);
+            for (size_t j = 0; j < len; j++) {
+                expected += probability->tiles[scratch->vars[scratch->order[component->var_start + j]]];
+            }
+        }
+        if (outside > 0) {
+            double rest = ((double)mines - expected) / outside;
+            density = rest < 0 ? 0 : rest > 1 ? 1 : rest;
+        }
+    }
+    free(weight);
+    return density;
+}
+
+// combine the components exactly: every way of splitting the mines between them and the outside
+// tiles is weighted by how many layouts it allows. returns the chance for outside tiles, or -1 if
+// out of memory
+static float combine_exact(struct Probability *probability, struct Scratch *scratch, size_t mines, size_t outside) {
+    size_t n = 0; // exact components
+    size_t total = 0; // tiles in them
+    for (size_t i = 0; i < scratch->components_len; i++) {
+        if (scratch->components[i].result.exact) {
+            n++;
+            total += scratch->components[i].result.len;
+        }
+    }
+    // prefix[i] = layouts of the first i exact components combined, by mine count
+    double **prefix = calloc(n + 1, sizeof(double *));
+    double *weight = malloc((total + 1) * sizeof(double));
+    double *suffix = malloc((total + 1) * sizeof(double));
+    double *rest = malloc((total + 1) * sizeof(double));
+    double *tmp = malloc((total + 1) * sizeof(double));
+    double *component_weight = malloc((MAX_COMPONENT_VARS + 1) * sizeof(double));
+    struct Component **exact = malloc((n + 1) * sizeof(struct Component *));
+    bool ok = prefix && weight && suffix && rest && tmp && component_weight && exact;
+    float chance = -1;
+    if (!ok) {
+        goto done;
+    }
+    n = 0;
+    for (size_t i = 0; i < scratch->components_len; i++) {
+        if (scratch->components[i].result.exact) {
+            exact[n++] = &scratch->components[i];
+        }
+    }
+
+    // weight[t] = ways to put the other (mines - t) mines in the outside tiles
+    double max = -INFINITY;
+    for (size_t t = 0; t <= total; t++) {
+        weight[t] = t <= mines && mines - t <= outside ? log_choose(outside, mines - t) : -INFINITY;
+        max = weight[t] > max ? weight[t] : max;
+    }
+    for (size_t t = 0; t <= total; t++) {
+        weight[t] = max == -INFINITY ? 0 : exp(weight[t] - max);
+    }
+
+    size_t prefix_len = 1;
+    prefix[0] = malloc(sizeof(double));
+    if (!prefix[0]) {
+        goto done;
+    }
+    prefix[0][0] = 1;
+    for (size_t i = 0; i < n; i++) {
+        size_t len = exact[i]->result.len;
+        prefix[i + 1] = malloc((prefix_len + len) * sizeof(double));
+        if (!prefix[i + 1]) {
+            goto done;
+        }
+        convolve(prefix[i], prefix_len, exact[i]->result.counts, len + 1, prefix[i + 1]);
+        prefix_len += len;
+    }
+
+    // outside tiles: expected leftover mines over how many tiles they're spread across
+    if (outside > 0) {
+        double sum = 0, expected = 0;
+        for (size_t t = 0; t < prefix_len; t++) {
+            sum += prefix[n][t] * weight[t];
+            expected += prefix[n][t] * weight[t] * ((double)mines - t);
+        }
+        chance = sum > 0 ? expected / sum / outside : 0;
+    } else {
+        chance = 0;
+    }
+
+    // go backwards so the suffix (layouts of the components after this one) can be built up as we go
+    size_t suffix_len = 1;
+    suffix[0] = 1;
+    prefix_len = total + 1;
+    for (size_t i = n; i-- > 0;) {
+        size_t len = exact[i]->result.len;
+        prefix_len -= len;
+        // every other component combined
+        convolve(prefix[i], prefix_len, suffix, suffix_len, rest);
+        size_t rest_len = prefix_len + suffix_len - 1;
+        for (size_t k = 0; k <= len; k++) {
+            double sum = 0;
+            for (size_t j = 0; j < rest_len; j++) {
+                sum += rest[j] * weight[k + j];
+            }
+            component_weight[k] = sum;
+        }
+        component_probabilities(probability, scratch, exact[i], component_weight);
+
+        convolve(suffix, suffix_len, exact[i]->result.counts, len + 1, tmp);
+        suffix_len += len;
+        memcpy(suffix, tmp, suffix_len * sizeof(double));
+    }
+
+done:
+    if (prefix) {
+        for (size_t i = 0; i <= n; i++) {
+            free(prefix[i]);
+        }
+    }
+    free(prefix);
+    free(weight);
+    free(suffix);
+    free(rest);
+    free(tmp);
+    free(component_weight);
+    free(exact);
+    return chance;
+}
+
+static void scratch_free(struct Scratch *scratch) {
+    free(scratch->var_of);
+    free(scratch->vars);
+    free(scratch->cons);
+    free(scratch->parent);
+    free(scratch->order);
+    free(scratch->component_cons);
+    if (scratch->components) {
+        for (size_t i = 0; i < scratch->components_len; i++) {
+            struct Component *component = &scratch->components[i];
+            free(component->signature);
+            if (!component->from_memo) {
+                result_free(&component->result);
+            }
+        }
+    }
+    free(scratch->components);
+}
+
+bool probability_compute(struct Probability *probability) {
+    struct Minefield *minefield = probability->minefield;
+    size_t tiles_len = minefield->width * minefield->height;
+    solver_solve(probability->solver);
+
+    struct Scratch scratch = {0};
+    bool ok = false;
+    float *tiles = probability->tiles_len == tiles_len ? probability->tiles : NULL;
+    if (!tiles) {
+        tiles = malloc(tiles_len * sizeof(float));
+        if (!tiles) {
+            return false;
+        }
+    }
+    scratch.var_of = calloc(tiles_len, sizeof(uint32_t));
+    size_t outside, known_mines;
+    if (!scratch.var_of || !collect_frontier(probability, &scratch, &outside, &known_mines) || !split_components(&scratch)) {
+        goto done;
+    }
+    // the old values are still needed if anything below fails
+    float *old_tiles = probability->tiles;
+    probability->tiles = tiles;
+    if (!enumerate_components(probability, &scratch)) {
+        probability->tiles = old_tiles;
+        goto done;
+    }
+
+    size_t mines = minefield->mines - known_mines;
+    bool exact = true;
+    size_t exact_tiles = 0;
+    for (size_t i = 0; i < scratch.components_len; i++) {
+        struct Component *component = &scratch.components[i];
+        if (component->result.exact) {
+            exact_tiles += component->len;
+        } else {
+            outside += component->len; // treated like tiles no number touches
+            exact = false;
+        }
+    }
+    float chance = -1;
+    if ((double)scratch.components_len * exact_tiles * exact_tiles <= MAX_COMBINE_STEPS) {
+        chance = combine_exact(probability, &scratch, mines, outside);
+    }
+    if (chance < 0) {
+        chance = combine_independent(probability, &scratch, mines, outside);
+        exact = false;
+    }
+
+    uint8_t *known = probability->solver->tiles;
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            size_t offset = y * minefield->width + x;
+            if (tile_is_visible(minefield_get_tile(minefield, x, y)) || (known[offset] & SOLVER_SAFE)) {
+                tiles[offset] = 0;
+            } else if (known[offset] & SOLVER_MINE) {
+                tiles[offset] = 1;
+            } else if (!scratch.var_of[offset]) {
+                tiles[offset] = chance;
+            }
+            // frontier tiles were filled in by combine_*, except for estimated components
+        }
+    }
+    for (size_t i = 0; i < scratch.components_len; i++) {
+        struct Component *component = &scratch.components[i];
+        if (!component->result.exact) {
+            for (size_t j = 0; j < component->len; j++) {
+                tiles[scratch.vars[scratch.order[component->var_start + j]]] = chance;
+            }
+        }
+    }
+
+    if (old_tiles != tiles) {
+        free(old_tiles);
+    }
+    probability->tiles_len = tiles_len;
+    probability->outside = chance;
+    probability->exact = exact;
+    probability->generation++;
+    probability->solver_revision = probability->solver->revision;
+    ok = true;
+
+done:
+    if (!ok && tiles != probability->tiles) {
+        free(tiles);
+    }
+    scratch_free(&scratch);
+    // not before now: components taken from the memo (or just put in it) borrow its results until here
+    if (probability->memo && probability->memo->bytes > MAX_MEMO_BYTES) {
+        memo_clear(probability->memo);
+    }
+    return ok;
+}
+
+bool probability_best_guess(struct Probability *probability, size_t x, size_t y, size_t *guess_x, size_t *guess_y) {
+    struct Minefield *minefield = probability->minefield;
+    if (!probability->tiles) {
+        return false;
+    }
+    bool found = false;
+    float best = 2;
+    size_t best_distance = SIZE_MAX;
+    for (size_t y1 = 0; y1 < minefield->height; y1++) {
+        for (size_t x1 = 0; x1 < minefield->width; x1++) {
+            struct Tile *tile = minefield_get_tile(minefield, x1, y1);
+            if (tile_is_visible(tile) || tile_is_flagged(tile)) {
+                continue;
+            }
+            float chance = probability->tiles[y1 * minefield->width + x1];
+            size_t dx = x1 > x ? x1 - x : x - x1;
+            size_t dy = y1 > y ? y1 - y : y - y1;
+            size_t distance = dx > dy ? dx : dy;
+            if (chance < best || (chance == best && distance < best_distance)) {
+                best = chance;
+                best_distance = distance;
+                *guess_x = x1;
+                *guess_y = y1;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
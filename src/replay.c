@@ -0,0 +1,623 @@
+#define _POSIX_C_SOURCE 200809L // mmap, fstat
+
+#include "replay.h"
+
+#include "game.h"
+#include "journal.h"
+#include "minefield.h"
+#include "noguess.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char REPLAY_MAGIC[4] = { 'S', 'M', 'R', 'P' };
+
+// visible | flagged << 1, what replays store about a tile
+static inline uint8_t replay_tile_state(const struct Tile *tile) {
+    return tile_is_visible(tile) | tile_is_flagged(tile) << 1;
+}
+static inline uint64_t replay_zigzag(int64_t value) {
+    return (uint64_t)value << 1 ^ (uint64_t)(value >> 63);
+}
+static inline int64_t replay_unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// writing
+
+static void replay_scratch_byte(struct ReplayWriter *writer, uint8_t byte) {
+    if (writer->failed) {
+        return;
+    }
+    if (writer->scratch.len == writer->scratch.cap) {
+        size_t cap = writer->scratch.cap ? writer->scratch.cap * 2 : 256;
+        uint8_t *items = realloc(writer->scratch.items, cap);
+        if (!items) {
+            // the event is cut short, so nothing more can be written after it
+            writer->failed = true;
+            return;
+        }
+        writer->scratch.items = items;
+        writer->scratch.cap = cap;
+    }
+    writer->scratch.items[writer->scratch.len++] = byte;
+}
+static void replay_scratch_varint(struct ReplayWriter *writer, uint64_t value) {
+    while (value >= 0x80) {
+        replay_scratch_byte(writer, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    replay_scratch_byte(writer, (uint8_t)value);
+}
+// write out and empty the scratch buffer. once a write failed nothing is written anymore, so the file
+// is still good up to the last event that made it
+static void replay_scratch_flush(struct ReplayWriter *writer) {
+    if (!writer->failed
+            && fwrite(writer->scratch.items, 1, writer->scratch.len, writer->file) != writer->scratch.len) {
+        writer->failed = true;
+    }
+    writer->scratch.len = 0;
+}
+
+static void replay_write_snapshot(struct ReplayWriter *writer) {
+    struct Minefield *minefield = &writer->game->minefield;
+    replay_scratch_varint(writer, writer->game_number);
+    replay_scratch_varint(writer, minefield->seed);
+    replay_scratch_varint(writer, writer->populated ? writer->first_x + 1 : 0);
+    replay_scratch_varint(writer, writer->populated ? writer->first_y + 1 : 0);
+    replay_scratch_varint(writer, writer->game->state);
+    replay_scratch_varint(writer, writer->cur_x);
+    replay_scratch_varint(writer, writer->cur_y);
+    replay_scratch_varint(writer, writer->game->guesses);
+    size_t run = 0;
+    uint8_t state = 0;
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            uint8_t tile_state = replay_tile_state(minefield_get_tile(minefield, x, y));
+            if (run > 0 && tile_state != state) {
+                replay_scratch_varint(writer, (uint64_t)run << 2 | state);
+                run = 0;
+            }
+            state = tile_state;
+            run++;
+        }
+    }
+    replay_scratch_varint(writer, (uint64_t)run << 2 | state);
+
+    // the length goes first, so the tag and length are written on their own
+    uint8_t head[11];
+    size_t head_len = 0;
+    head[head_len++] = REPLAY_SNAPSHOT;
+    for (uint64_t len = writer->scratch.len;; len >>= 7) {
+        head[head_len++] = (uint8_t)(len | (len >= 0x80 ? 0x80 : 0));
+        if (len < 0x80) {
+            break;
+        }
+    }
+    if (!writer->failed && fwrite(head, 1, head_len, writer->file) != head_len) {
+        writer->failed = true;
+    }
+    replay_scratch_flush(writer);
+    // snapshots are where a crashed session can still be played back up to
+    if (fflush(writer->file) != 0) {
+        writer->failed = true;
+    }
+}
+// the event in scratch is complete
+static void replay_end_event(struct ReplayWriter *writer) {
+    replay_scratch_flush(writer);
+    // a snapshot goes through the whole board, so on big ones they're further apart: never more than
+    // REPLAY_SNAPSHOT_TILES tiles of snapshot per event
+    size_t tiles_len = writer->game->minefield.width * writer->game->minefield.height;
+    size_t interval = tiles_len / REPLAY_SNAPSHOT_TILES > REPLAY_SNAPSHOT_INTERVAL
+                      ? tiles_len / REPLAY_SNAPSHOT_TILES : REPLAY_SNAPSHOT_INTERVAL;
+    if (++writer->since_snapshot >= interval) {
+        replay_write_snapshot(writer);
+        writer->since_snapshot = 0;
+    }
+}
+
+bool replay_writer_open(struct ReplayWriter *writer, const char *path, const struct ReplayHeader *header,
+                        struct Game *game) {
+    *writer = (struct ReplayWriter){0};
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        return false;
+    }
+    writer->game = game;
+    writer->game_number = 1;
+    // where minefield_init puts it
+    writer->cur_x = header->width / 2;
+    writer->cur_y = header->height / 2;
+
+    for (size_t i = 0; i < sizeof(REPLAY_MAGIC); i++) {
+        replay_scratch_byte(writer, REPLAY_MAGIC[i]);
+    }
+    replay_scratch_byte(writer, REPLAY_VERSION);
+    replay_scratch_varint(writer, header->width);
+    replay_scratch_varint(writer, header->height);
+    replay_scratch_varint(writer, header->mines);
+    replay_scratch_varint(writer, header->seed);
+    replay_scratch_varint(writer, header->no_guess);
+    replay_scratch_flush(writer);
+    return true;
+}
+
+bool replay_writer_close(struct ReplayWriter *writer) {
+    bool ok = !writer->failed;
+    if (writer->file && fclose(writer->file) != 0) {
+        ok = false;
+    }
+    free(writer->scratch.items);
+    *writer = (struct ReplayWriter){0};
+    return ok;
+}
+
+void replay_write_cursor(struct ReplayWriter *writer, size_t x, size_t y) {
+    if (x == writer->cur_x && y == writer->cur_y) {
+        return;
+    }
+    replay_scratch_byte(writer, REPLAY_CURSOR);
+    replay_scratch_varint(writer, replay_zigzag((int64_t)x - (int64_t)writer->cur_x));
+    replay_scratch_varint(writer, replay_zigzag((int64_t)y - (int64_t)writer->cur_y));
+    writer->cur_x = x;
+    writer->cur_y = y;
+    replay_end_event(writer);
+}
+
+void replay_write_action(struct ReplayWriter *writer, enum ReplayEvent event) {
+    if (event == REPLAY_REVEAL && !writer->populated) {
+        writer->populated = true;
+        writer->first_x = writer->cur_x;
+        writer->first_y = writer->cur_y;
+    }
+    replay_scratch_byte(writer, event);
+    replay_end_event(writer);
+}
+
+// one tile of a tile list, `last` is the offset of the one before it (0 for the first)
+static void replay_scratch_tile(struct ReplayWriter *writer, size_t *last, size_t offset, uint8_t state) {
+    replay_scratch_varint(writer, replay_zigzag((int64_t)offset - (int64_t)*last));
+    replay_scratch_varint(writer, state);
+    *last = offset;
+}
+
+void replay_write_autoplay(struct ReplayWriter *writer) {
+    struct Minefield *minefield = &writer->game->minefield;
+    replay_scratch_byte(writer, REPLAY_AUTOPLAY);
+    replay_scratch_varint(writer, writer->game->state);
+    replay_scratch_varint(writer, writer->game->guesses);
+    size_t last = 0;
+    if (!minefield->dirty.all) {
+        // everything autoplay changed is on the dirty list, along with whatever else changed since the
+        // last draw; those are written as they are, which is what playback already has anyway
+        replay_scratch_varint(writer, minefield->dirty.len);
+        for (size_t i = 0; i < minefield->dirty.len; i++) {
+            size_t offset = minefield->dirty.items[i];
+            struct Tile *tile = minefield_get_tile(minefield, offset % minefield->width, offset / minefield->width);
+            replay_scratch_tile(writer, &last, offset, replay_tile_state(tile));
+        }
+        replay_end_event(writer);
+        return;
+    }
+    // too much changed to list, but autoplay only ever reveals and flags, so every tile it touched is
+    // one that's visible or flagged now. the count goes first, so the board is gone through twice
+    size_t count = 0;
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            count += replay_tile_state(minefield_get_tile(minefield, x, y)) != 0;
+        }
+    }
+    replay_scratch_varint(writer, count);
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            uint8_t state = replay_tile_state(minefield_get_tile(minefield, x, y));
+            if (state) {
+                replay_scratch_tile(writer, &last, y * minefield->width + x, state);
+            }
+        }
+    }
+    replay_end_event(writer);
+}
+
+void replay_write_tiles(struct ReplayWriter *writer, size_t move) {
+    struct Minefield *minefield = &writer->game->minefield;
+    struct Journal *journal = &writer->game->journal;
+    size_t start, end;
+    journal_move_entries(journal, move, &start, &end);
+    replay_scratch_byte(writer, REPLAY_TILES);
+    replay_scratch_varint(writer, writer->game->state);
+    replay_scratch_varint(writer, end - start);
+    size_t last = 0;
+    for (size_t i = start; i < end; i++) {
+        // whatever the journal holds, the board has what the undo/redo left there
+        size_t offset = JOURNAL_ENTRY_OFFSET(journal->entries[i]);
+        struct Tile *tile = minefield_get_tile(minefield, offset % minefield->width, offset / minefield->width);
+        replay_scratch_tile(writer, &last, offset, replay_tile_state(tile));
+    }
+    replay_end_event(writer);
+}
+
+void replay_write_new_game(struct ReplayWriter *writer, uint64_t seed) {
+    writer->game_number++;
+    writer->populated = false;
+    writer->cur_x = writer->game->minefield.cur.x;
+    writer->cur_y = writer->game->minefield.cur.y;
+    replay_scratch_byte(writer, REPLAY_NEW_GAME);
+    replay_scratch_varint(writer, seed);
+    replay_end_event(writer);
+}
+
+// reading
+
+struct ReplayReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool bad; // ran off the end, or a varint was too long; everything read after that is 0
+};
+
+static uint8_t replay_read_byte(struct ReplayReader *reader) {
+    if (reader->p == reader->end) {
+        reader->bad = true;
+        return 0;
+    }
+    return *reader->p++;
+}
+static uint64_t replay_read_varint(struct ReplayReader *reader) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = replay_read_byte(reader);
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    reader->bad = true;
+    return 0;
+}
+
+// start the player's game over with a new seed, like main.c's game_init for every game
+static void replay_player_new_game(struct ReplayPlayer *player, uint64_t seed) {
+    game_init(&player->game, player->header.width, player->header.height, player->header.mines, seed, 0);
+    player->populated = false;
+}
+// same as the first reveal in main.c: the board is made around the cursor
+static void replay_player_populate(struct ReplayPlayer *player) {
+    if (player->header.no_guess) {
+        noguess_populate(&player->game.minefield, 0);
+    } else {
+        minefield_populate(&player->game.minefield);
+    }
+    player->populated = true;
+}
+
+// move a cursor by a cursor event's changes, false if that goes off the board
+static bool replay_move_cursor(struct ReplayReader *reader, const struct ReplayHeader *header, size_t *x, size_t *y) {
+    int64_t dx = replay_unzigzag(replay_read_varint(reader));
+    int64_t dy = replay_unzigzag(replay_read_varint(reader));
+    if ((dx < 0 && (uint64_t)-dx > *x) || (dx > 0 && (uint64_t)dx >= header->width - *x)
+            || (dy < 0 && (uint64_t)-dy > *y) || (dy > 0 && (uint64_t)dy >= header->height - *y)) {
+        return false;
+    }
+    *x += dx;
+    *y += dy;
+    return true;
+}
+
+// check one snapshot body (everything after its length), and set the cursor to the snapshot's
+static bool replay_check_snapshot(struct ReplayReader *reader, const struct ReplayHeader *header, size_t *x, size_t *y) {
+    replay_read_varint(reader); // game number
+    replay_read_varint(reader); // seed
+    uint64_t first_x = replay_read_varint(reader);
+    uint64_t first_y = replay_read_varint(reader);
+    uint64_t state = replay_read_varint(reader);
+    uint64_t cur_x = replay_read_varint(reader);
+    uint64_t cur_y = replay_read_varint(reader);
+    replay_read_varint(reader); // guesses
+    if (first_x > header->width || first_y > header->height || (first_x == 0) != (first_y == 0)
+            || state > DEAD || cur_x >= header->width || cur_y >= header->height) {
+        return false;
+    }
+    size_t tiles_len = header->width * header->height;
+    size_t covered = 0;
+    while (covered < tiles_len && !reader->bad) {
+        uint64_t run = replay_read_varint(reader) >> 2;
+        if (run == 0 || run > tiles_len - covered) {
+            return false;
+        }
+        covered += run;
+    }
+    *x = cur_x;
+    *y = cur_y;
+    return !reader->bad && reader->p == reader->end;
+}
+
+// check a tile list: the count, then every tile has to be on the board
+static bool replay_check_tiles(struct ReplayReader *reader, size_t tiles_len) {
+    uint64_t count = replay_read_varint(reader);
+    int64_t tile = 0;
+    for (uint64_t i = 0; i < count && !reader->bad; i++) {
+        tile += replay_unzigzag(replay_read_varint(reader));
+        if (tile < 0 || (uint64_t)tile >= tiles_len || replay_read_varint(reader) > 3) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// check every event, count them and find the snapshots; only ever called from replay_player_open
+static bool replay_player_scan(struct ReplayPlayer *player) {
+    const struct ReplayHeader *header = &player->header;
+    struct ReplayReader reader = { player->data + player->events_offset, player->data + player->len, false };
+    size_t tiles_len = header->width * header->height;
+    size_t cur_x = header->width / 2;
+    size_t cur_y = header->height / 2;
+    size_t snapshots_cap = 0;
+    while (reader.p < reader.end) {
+        size_t offset = reader.p - player->data;
+        uint8_t tag = replay_read_byte(&reader);
+        switch (tag) {
+            case REPLAY_CURSOR:
+                if (!replay_move_cursor(&reader, header, &cur_x, &cur_y)) {
+                    return false;
+                }
+                break;
+            case REPLAY_REVEAL:
+            case REPLAY_FLAG:
+                break;
+            case REPLAY_AUTOPLAY:
+                if (replay_read_varint(&reader) > DEAD) {
+                    return false;
+                }
+                replay_read_varint(&reader); // guesses
+                if (!replay_check_tiles(&reader, tiles_len)) {
+                    return false;
+                }
+                break;
+            case REPLAY_TILES:
+                if (replay_read_varint(&reader) > DEAD || !replay_check_tiles(&reader, tiles_len)) {
+                    return false;
+                }
+                break;
+            case REPLAY_NEW_GAME:
+                replay_read_varint(&reader);
+                cur_x = header->width / 2;
+                cur_y = header->height / 2;
+                break;
+            case REPLAY_SNAPSHOT: {
+                uint64_t len = replay_read_varint(&reader);
+                if (reader.bad || len > (uint64_t)(reader.end - reader.p)) {
+                    return false;
+                }
+                struct ReplayReader body = { reader.p, reader.p + len, false };
+                if (!replay_check_snapshot(&body, header, &cur_x, &cur_y)) {
+                    return false;
+                }
+                reader.p += len;
+                if (player->snapshots.len == snapshots_cap) {
+                    snapshots_cap = snapshots_cap ? snapshots_cap * 2 : 16;
+                    struct ReplaySeekPoint *items = realloc(player->snapshots.items,
+                                                            snapshots_cap * sizeof(struct ReplaySeekPoint));
+                    if (!items) {
+                        return false;
+                    }
+                    player->snapshots.items = items;
+                }
+                player->snapshots.items[player->snapshots.len++] = (struct ReplaySeekPoint){ player->events, offset };
+                continue; // not an event
+            }
+            default:
+                return false;
+        }
+        if (reader.bad) {
+            return false;
+        }
+        player->events++;
+    }
+    return true;
+}
+
+bool replay_player_open(struct ReplayPlayer *player, const char *path) {
+    *player = (struct ReplayPlayer){0};
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    player->data = data;
+    player->len = st.st_size;
+
+    struct ReplayReader reader = { player->data, player->data + player->len, false };
+    for (size_t i = 0; i < sizeof(REPLAY_MAGIC); i++) {
+        if (replay_read_byte(&reader) != (uint8_t)REPLAY_MAGIC[i]) {
+            return false;
+        }
+    }
+    if (replay_read_byte(&reader) != REPLAY_VERSION) {
+        return false;
+    }
+    struct ReplayHeader *header = &player->header;
+    header->width = replay_read_varint(&reader);
+    header->height = replay_read_varint(&reader);
+    header->mines = replay_read_varint(&reader);
+    header->seed = replay_read_varint(&reader);
+    header->no_guess = replay_read_varint(&reader);
+    // the same limits main.c puts on a board
+    if (reader.bad || header->width < 5 || header->height < 5 || header->width > SIZE_MAX / header->height
+            || header->mines > header->width * header->height - 9) {
+        return false;
+    }
+    player->events_offset = reader.p - player->data;
+    if (!replay_player_scan(player)) {
+        return false;
+    }
+
+    player->game_number = 1;
+    player->offset = player->events_offset;
+    replay_player_new_game(player, header->seed);
+    return player->game.minefield.tiles != NULL;
+}
+
+void replay_player_close(struct ReplayPlayer *player) {
+    if (player->data) {
+        munmap((void *)player->data, player->len);
+        game_cleanup(&player->game);
+    }
+    free(player->snapshots.items);
+    *player = (struct ReplayPlayer){0};
+}
+
+// set a tile's visible and flagged bits to a replay tile state
+static void replay_player_set_tile(struct ReplayPlayer *player, size_t offset, uint8_t state) {
+    struct Minefield *minefield = &player->game.minefield;
+    struct Tile *tile = minefield_get_tile(minefield, offset % minefield->width, offset / minefield->width);
+    uint8_t bits = (state & 1 ? TILE_VISIBLE_BIT : 0) | (state & 2 ? TILE_FLAGGED_BIT : 0);
+    if (bits != (tile->bits & (TILE_VISIBLE_BIT | TILE_FLAGGED_BIT))) {
+        minefield_swap_tile_marks(minefield, offset, &bits);
+    }
+}
+// apply a (checked) tile list
+static void replay_player_apply_tiles(struct ReplayPlayer *player, struct ReplayReader *reader) {
+    uint64_t count = replay_read_varint(reader);
+    size_t offset = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        offset += replay_unzigzag(replay_read_varint(reader));
+        replay_player_set_tile(player, offset, replay_read_varint(reader));
+    }
+}
+
+// put the game into the state a (checked) snapshot body describes
+static void replay_player_restore(struct ReplayPlayer *player, struct ReplayReader *reader) {
+    struct Minefield *minefield = &player->game.minefield;
+    player->game_number = replay_read_varint(reader);
+    replay_player_new_game(player, replay_read_varint(reader));
+    size_t first_x = replay_read_varint(reader);
+    size_t first_y = replay_read_varint(reader);
+    if (first_x) {
+        minefield_set_cursor(minefield, first_x - 1, first_y - 1);
+        replay_player_populate(player);
+    }
+    enum GameState state = replay_read_varint(reader);
+    size_t cur_x = replay_read_varint(reader);
+    size_t cur_y = replay_read_varint(reader);
+    player->game.guesses = replay_read_varint(reader);
+
+    size_t tiles_len = minefield->width * minefield->height;
+    for (size_t offset = 0; offset < tiles_len;) {
+        uint64_t run = replay_read_varint(reader);
+        for (size_t end = offset + (run >> 2); offset < end; offset++) {
+            replay_player_set_tile(player, offset, run & 3);
+        }
+    }
+    player->game.state = state;
+    minefield_set_cursor(minefield, cur_x, cur_y);
+}
+
+bool replay_player_step(struct ReplayPlayer *player) {
+    struct Game *game = &player->game;
+    struct Minefield *minefield = &game->minefield;
+    struct ReplayReader reader = { player->data + player->offset, player->data + player->len, false };
+    // everything was checked by replay_player_scan, so this only has to skip snapshots
+    uint8_t tag = 0;
+    while (reader.p < reader.end && (tag = replay_read_byte(&reader)) == REPLAY_SNAPSHOT) {
+        uint64_t len = replay_read_varint(&reader);
+        reader.p += len;
+        tag = 0;
+    }
+    if (tag == 0) {
+        player->offset = reader.p - player->data;
+        return false;
+    }
+    size_t x = minefield->cur.x;
+    size_t y = minefield->cur.y;
+    switch (tag) {
+        case REPLAY_CURSOR:
+            replay_move_cursor(&reader, &player->header, &x, &y);
+            minefield_set_cursor(minefield, x, y);
+            break;
+        case REPLAY_REVEAL:
+            // what main.c does for space
+            if (!player->populated) {
+                replay_player_populate(player);
+                minefield_reveal_tile(minefield, x, y);
+            } else if (game->state == ALIVE && !tile_is_flagged(minefield_get_tile(minefield, x, y))) {
+                game_click_tile(game, x, y);
+            }
+            break;
+        case REPLAY_FLAG:
+            if (game->state == ALIVE) {
+                game_toggle_flag(game, x, y);
+            }
+            break;
+        case REPLAY_AUTOPLAY:
+            game->state = replay_read_varint(&reader);
+            game->guesses = replay_read_varint(&reader);
+            replay_player_apply_tiles(player, &reader);
+            break;
+        case REPLAY_TILES:
+            game->state = replay_read_varint(&reader);
+            replay_player_apply_tiles(player, &reader);
+            break;
+        case REPLAY_NEW_GAME:
+            player->game_number++;
+            replay_player_new_game(player, replay_read_varint(&reader));
+            break;
+    }
+    player->offset = reader.p - player->data;
+    player->event++;
+    return true;
+}
+
+void replay_player_seek(struct ReplayPlayer *player, uint64_t event) {
+    if (event > player->events) {
+        event = player->events;
+    }
+    // the last snapshot at or before the event
+    size_t low = 0;
+    size_t high = player->snapshots.len;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (player->snapshots.items[mid].event <= event) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    const struct ReplaySeekPoint *from = low > 0 ? &player->snapshots.items[low - 1] : NULL;
+    // going forward from where the player already is can be closer than the snapshot
+    if (event < player->event || (from && from->event > player->event)) {
+        if (from) {
+            struct ReplayReader reader = { player->data + from->offset + 1, player->data + player->len, false };
+            uint64_t len = replay_read_varint(&reader);
+            struct ReplayReader body = { reader.p, reader.p + len, false };
+            replay_player_restore(player, &body);
+            player->offset = body.end - player->data;
+            player->event = from->event;
+        } else {
+            player->game_number = 1;
+            replay_player_new_game(player, player->header.seed);
+            player->offset = player->events_offset;
+            player->event = 0;
+        }
+    }
+    while (player->event < event && replay_player_step(player)) {
+    }
+}
@@ -0,0 +1,55 @@
+#include "rng.h"
+
+#include <stdint.h>
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(struct Rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+uint64_t rng_next(struct Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+uint64_t rng_below(struct Rng *rng, uint64_t n) {
+    // plain `% n` favors small numbers, so throw away the 2^64 % n values at the bottom
+    // (-n) % n == 2^64 % n, and for board sized n this almost never needs a second try
+    uint64_t threshold = (0 - n) % n;
+    for (;;) {
+        uint64_t r = rng_next(rng);
+        if (r >= threshold) {
+            return r % n;
+        }
+    }
+}
+
+uint64_t rng_derive_seed(uint64_t seed, uint64_t index) {
+    if (index == 0) {
+        return seed;
+    }
+    uint64_t state = seed ^ (index * 0xd1b54a32d192ed03);
+    return splitmix64(&state);
+}
@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L // mmap, fstat, fsync
+
+#include "save.h"
+
+#include "game.h"
+#include "journal.h"
+#include "minefield.h"
+#include "solver.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAVE_CHECKSUM_START 0xcbf29ce484222325
+
+// FNV-1a over 8 byte words (like probability.c's memo), and the bytes that are left one at a time
+static uint64_t save_checksum(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = data;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3;
+    }
+    for (; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// writing
+
+// fwrite that also adds what it wrote to a checksum
+static bool save_put(FILE *file, const void *data, size_t len, uint64_t *checksum) {
+    // an empty undo history has no entries array at all, and fwrite can't be handed NULL
+    if (len == 0) {
+        return true;
+    }
+    *checksum = save_checksum(*checksum, data, len);
+    return fwrite(data, 1, len, file) == len;
+}
+
+static bool save_write_file(struct Game *game, FILE *file) {
+    struct Minefield *minefield = &game->minefield;
+    struct Journal *journal = &game->journal;
+    struct SaveHeader header = {
+        .magic = SAVE_MAGIC,
+        .version = SAVE_VERSION,
+        .width = minefield->width,
+        .height = minefield->height,
+        .mines = minefield->mines,
+        .seed = minefield->seed,
+        .block_shift = minefield->block_shift,
+        .placed_flags = minefield->placed_flags,
+        .visible_tiles = minefield->visible_tiles,
+        .correct_flags = minefield->correct_flags,
+        .cur_x = minefield->cur.x,
+        .cur_y = minefield->cur.y,
+        .state = game->state,
+        .guesses = game->guesses,
+        .tiles_len = minefield_tiles_len(minefield),
+        .tiles_checksum = SAVE_CHECKSUM_START,
+        .journal_entries = journal->len,
+        .journal_moves = journal->moves_len,
+        .journal_head = journal->head,
+        .journal_checksum = SAVE_CHECKSUM_START,
+        .solver_checksum = SAVE_CHECKSUM_START,
+    };
+
+    // the header goes in last, once the checksums are known
+    static const uint8_t zeroes[SAVE_TILES_OFFSET];
+    if (fwrite(zeroes, 1, sizeof(zeroes), file) != sizeof(zeroes)) {
+        return false;
+    }
+    // the dirty bits only mean something together with minefield.dirty, so they're left out. so are the
+    // mines before the first click (a board made ahead by pregen has them already), loading has to
+    // leave them to the first click like on any new board
+    uint8_t keep = minefield->visible_tiles ? (uint8_t)~TILE_DIRTY_BIT : TILE_FLAGGED_BIT;
+    uint8_t buffer[65536];
+    for (size_t i = 0; i < header.tiles_len;) {
+        size_t len = header.tiles_len - i < sizeof(buffer) ? header.tiles_len - i : sizeof(buffer);
+        for (size_t j = 0; j < len; j++) {
+            buffer[j] = minefield->tiles[i + j].bits & keep;
+        }
+        if (!save_put(file, buffer, len, &header.tiles_checksum)) {
+            return false;
+        }
+        i += len;
+    }
+    if (!save_put(file, journal->entries, journal->len * sizeof(JournalEntry), &header.journal_checksum)) {
+        return false;
+    }
+    for (size_t i = 0; i < journal->moves_len; i++) {
+        struct JournalMove *move = &journal->moves[i];
+        int64_t fields[4] = { move->start, move->cur.x, move->cur.y, move->state };
+        if (!save_put(file, fields, sizeof(fields), &header.journal_checksum)) {
+            return false;
+        }
+    }
+    // only the tiles something was found about, they're few next to the whole board
+    struct Solver *solver = minefield->solver;
+    size_t tiles = minefield->width * minefield->height;
+    for (size_t offset = 0; solver && offset < tiles; offset++) {
+        uint64_t known = solver->tiles[offset] & (SOLVER_SAFE | SOLVER_MINE);
+        if (known) {
+            known |= (uint64_t)offset << 2;
+            if (!save_put(file, &known, sizeof(known), &header.solver_checksum)) {
+                return false;
+            }
+            header.solver_tiles++;
+        }
+    }
+
+    header.header_checksum = save_checksum(SAVE_CHECKSUM_START, &header, offsetof(struct SaveHeader, header_checksum));
+    return fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, 1, sizeof(header), file) == sizeof(header)
+        && fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+bool save_write(struct Game *game, const char *path) {
+    size_t tmp_len = strlen(path) + sizeof(".tmp");
+    char *tmp = malloc(tmp_len);
+    if (!tmp) {
+        return false;
+    }
+    snprintf(tmp, tmp_len, "%s.tmp", path);
+    FILE *file = fopen(tmp, "wb");
+    bool ok = file != NULL;
+    if (file) {
+        ok = save_write_file(game, file);
+        ok = fclose(file) == 0 && ok;
+        ok = ok && rename(tmp, path) == 0;
+        if (!ok) {
+            remove(tmp);
+        }
+    }
+    free(tmp);
+    return ok;
+}
+
+// reading
+
+// check everything in the header that can be checked without looking at the board
+static bool save_check_header(const struct SaveHeader *header, size_t file_len) {
+    if (header->magic != SAVE_MAGIC || header->version != SAVE_VERSION
+            || header->header_checksum != save_checksum(SAVE_CHECKSUM_START, header,
+                                                        offsetof(struct SaveHeader, header_checksum))) {
+        return false;
+    }
+    // the same limits main.c puts on a board
+    if (header->width < 5 || header->height < 5 || header->width > SIZE_MAX / header->height
+            || header->mines > header->width * header->height - 9 || header->block_shift > 16) {
+        return false;
+    }
+    // minefield_tiles_len needs a minefield, and a board isn't made until everything checks out
+    struct Minefield sizes = { .width = header->width, .height = header->height, .block_shift = header->block_shift };
+    if (sizes.block_shift) {
+        size_t block = (size_t)1 << sizes.block_shift;
+        sizes.blocks_wide = (sizes.width + block - 1) / block;
+    }
+    size_t tiles = header->width * header->height;
+    if (header->tiles_len != minefield_tiles_len(&sizes) || header->placed_flags > tiles
+            || header->visible_tiles > tiles || header->correct_flags > header->placed_flags
+            || header->cur_x >= header->width || header->cur_y >= header->height || header->state > DEAD) {
+        return false;
+    }
+    // everything after the tiles has to be in the file, without overflowing on the way
+    if (file_len < SAVE_TILES_OFFSET || header->tiles_len > file_len - SAVE_TILES_OFFSET) {
+        return false;
+    }
+    size_t left = file_len - SAVE_TILES_OFFSET - header->tiles_len;
+    if (header->journal_entries > left / sizeof(JournalEntry)) {
+        return false;
+    }
+    left -= header->journal_entries * sizeof(JournalEntry);
+    if (header->journal_moves > left / (4 * sizeof(int64_t)) || header->journal_head > header->journal_moves) {
+        return false;
+    }
+    left -= header->journal_moves * 4 * sizeof(int64_t);
+    return header->solver_tiles <= left / sizeof(uint64_t);
+}
+
+// copy the undo history out of the file into a struct Journal's arrays, checking it on the way
+static bool save_read_journal(const struct SaveHeader *header, const uint8_t *data, JournalEntry **entries,
+                              struct JournalMove **moves) {
+    size_t entries_len = header->journal_entries * sizeof(JournalEntry);
+    size_t moves_len = header->journal_moves * 4 * sizeof(int64_t);
+    if (header->journal_checksum != save_checksum(save_checksum(SAVE_CHECKSUM_START, data, entries_len),
+                                                  data + entries_len, moves_len)) {
+        return false;
+    }
+    // malloc(0) is allowed to return NULL
+    *entries = malloc(entries_len ? entries_len : 1);
+    *moves = malloc(header->journal_moves ? header->journal_moves * sizeof(struct JournalMove) : 1);
+    if (!*entries || !*moves) {
+        free(*entries);
+        free(*moves);
+        return false;
+    }
+    memcpy(*entries, data, entries_len);
+    size_t tiles = header->width * header->height;
+    size_t last_start = 0;
+    for (size_t i = 0; i < header->journal_moves; i++) {
+        int64_t fields[4];
+        memcpy(fields, data + entries_len + i * sizeof(fields), sizeof(fields));
+        struct JournalMove *move = &(*moves)[i];
+        move->start = fields[0];
+        move->cur.x = fields[1];
+        move->cur.y = fields[2];
+        move->state = fields[3];
+        // moves are in order and every entry is on the board, so undo can't go off the end of anything
+        if (fields[0] < 0 || move->start < last_start || move->start > header->journal_entries
+                || fields[1] < 0 || (uint64_t)fields[1] >= header->width
+                || fields[2] < 0 || (uint64_t)fields[2] >= header->height || fields[3] < 0 || fields[3] > DEAD) {
+            free(*entries);
+            free(*moves);
+            return false;
+        }
+        last_start = move->start;
+    }
+    for (size_t i = 0; i < header->journal_entries; i++) {
+        if (JOURNAL_ENTRY_OFFSET((*entries)[i]) >= tiles) {
+            free(*entries);
+            free(*moves);
+            return false;
+        }
+    }
+    return true;
+}
+
+// check what the solver found, and put it into a solver that was just initialized
+static bool save_check_solver(const struct SaveHeader *header, const uint8_t *data) {
+    size_t tiles = header->width * header->height;
+    if (header->solver_checksum != save_checksum(SAVE_CHECKSUM_START, data, header->solver_tiles * sizeof(uint64_t))) {
+        return false;
+    }
+    for (size_t i = 0; i < header->solver_tiles; i++) {
+        uint64_t known;
+        memcpy(&known, data + i * sizeof(known), sizeof(known));
+        if ((known >> 2) >= tiles || (known & 3) == 0 || (known & 3) == 3) {
+            return false;
+        }
+    }
+    return true;
+}
+static void save_read_solver(const struct SaveHeader *header, const uint8_t *data, struct Solver *solver) {
+    for (size_t i = 0; i < header->solver_tiles; i++) {
+        uint64_t known;
+        memcpy(&known, data + i * sizeof(known), sizeof(known));
+        solver->tiles[known >> 2] |= known & 3;
+    }
+}
+
+bool save_load(struct Game *game, const char *path, size_t undo_bytes) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < SAVE_TILES_OFFSET) {
+        close(fd);
+        return false;
+    }
+    size_t len = st.st_size;
+    // private and writable: the game changes its tiles right in the mapping, and the file never sees it
+    uint8_t *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    struct SaveHeader header;
+    memcpy(&header, map, sizeof(header));
+    JournalEntry *entries = NULL;
+    struct JournalMove *moves = NULL;
+    bool ok = save_check_header(&header, len);
+    if (ok && header.tiles_len <= SAVE_CHECK_MAX_TILES) {
+        ok = header.tiles_checksum == save_checksum(SAVE_CHECKSUM_START, map + SAVE_TILES_OFFSET, header.tiles_len);
+    }
+    const uint8_t *journal_data = map + SAVE_TILES_OFFSET + header.tiles_len;
+    const uint8_t *solver_data = journal_data + header.journal_entries * sizeof(JournalEntry)
+                               + header.journal_moves * 4 * sizeof(int64_t);
+    ok = ok && save_check_solver(&header, solver_data);
+    // without undo the history isn't needed, so it isn't even looked at
+    if (ok && undo_bytes) {
+        ok = save_read_journal(&header, journal_data, &entries, &moves);
+    }
+    if (!ok) {
+        munmap(map, len);
+        return false;
+    }
+
+    game->minefield.block_shift = header.block_shift;
+    game_init(game, header.width, header.height, header.mines, header.seed, undo_bytes);
+    struct Minefield *minefield = &game->minefield;
+    minefield_adopt_tiles(minefield, (struct Tile *)(map + SAVE_TILES_OFFSET), map, len);
+    minefield->placed_flags = header.placed_flags;
+    minefield->visible_tiles = header.visible_tiles;
+    minefield->correct_flags = header.correct_flags;
+    minefield->cur.x = header.cur_x;
+    minefield->cur.y = header.cur_y;
+    game->state = header.state;
+    game->guesses = header.guesses;
+    if (undo_bytes) {
+        struct Journal *journal = &game->journal;
+        free(journal->entries);
+        free(journal->moves);
+        journal->entries = entries;
+        journal->len = journal->cap = header.journal_entries;
+        journal->moves = moves;
+        journal->moves_len = journal->moves_cap = header.journal_moves;
+        journal->head = header.journal_head;
+    }
+    // the solver only hears about reveals as they happen, so it has to look at the whole board once;
+    // that waits until it's first needed
+    if (minefield->solver) {
+        save_read_solver(&header, solver_data, minefield->solver);
+        minefield->solver->stale = true;
+    }
+    // the tiles were all read for the checksum anyway, so indexing them too doesn't cost much more
+    if (minefield->index_openings && minefield->visible_tiles > 0 && header.tiles_len <= SAVE_CHECK_MAX_TILES) {
+        minefield_index_openings(minefield);
+    }
+    return true;
+}
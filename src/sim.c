@@ -0,0 +1,316 @@
+// smines-sim: plays lots of games with the autoplayer and prints how it went, for judging changes
+// to the board generator and the solver
+//
+// every game is: populate around a first click in the middle, click it, then game_autoplay with
+// guessing until the game is over. prints one CSV row per difficulty to stdout.
+// boards that fit a struct Bitboard (every preset) are played there first, with the same single point
+// deductions game_autoplay starts with. most games are decided before those get stuck; the rest go
+// on with game_autoplay from the same spot, so the numbers are the same as playing it all out there.
+// game i always gets the seed rng_derive_seed(seed, i), so the totals only depend on --seed and
+// --games, never on how many threads shared the work. build with `--buildtype=release
+// -Db_ndebug=true` for real numbers, the debug checks in minefield_check_victory are slow.
+#define _POSIX_C_SOURCE 200809L
+
+#include "bitboard.h"
+#include "difficulty.h"
+#include "game.h"
+#include "minefield.h"
+#include "noguess.h"
+#include "rng.h"
+
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const uint64_t DEFAULT_SEED = 0x736d696e6573; // "smines", same as smines-bench
+static const uint64_t DEFAULT_GAMES = 100000;
+// games a thread takes at once, so the shared counter isn't touched after every game
+static const uint64_t BATCH = 256;
+static const int MAX_THREADS = 256;
+
+struct SimStats {
+    uint64_t games;
+    uint64_t wins;
+    uint64_t guesses;
+    uint64_t bv; // sum of every board's 3BV
+    uint64_t bv_games; // boards that went into bv, the 3BV is skipped if there wasn't memory to work it out
+    uint64_t openings; // and of their openings
+};
+
+struct SimJob {
+    const struct Difficulty *difficulty;
+    uint64_t seed;
+    uint64_t games;
+    bool no_guess;
+    uint64_t next; // first game of the next batch, taken with __atomic_fetch_add
+};
+
+// one per thread, nothing in here is shared
+struct SimWorker {
+    struct SimJob *job;
+    // reused for every game the thread plays, so its buffers only have to grow once
+    struct Game game;
+    struct Bitboard board;
+    struct SimStats stats;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// play a board that fits on the bitboard until the single point deductions get stuck, false if the
+// game isn't over by then
+static bool sim_play_bitboard(struct SimWorker *worker, uint64_t seed) {
+    const struct Difficulty *difficulty = worker->job->difficulty;
+    struct Bitboard *board = &worker->board;
+    size_t x = difficulty->width / 2;
+    size_t y = difficulty->height / 2;
+    bitboard_init(board, difficulty->width, difficulty->height, difficulty->mines);
+    bitboard_populate(board, seed, x, y);
+    size_t openings;
+    worker->stats.bv += bitboard_3bv(board, &openings);
+    worker->stats.bv_games++;
+    worker->stats.openings += openings;
+    bitboard_reveal(board, x, y); // the first click never has a mine around it
+    bitboard_solve(board);
+    if (bitboard_check_victory(board)) {
+        worker->stats.wins++;
+        return true;
+    }
+    return false;
+}
+
+static void sim_play(struct SimWorker *worker, uint64_t index) {
+    struct SimJob *job = worker->job;
+    struct Game *game = &worker->game;
+    uint64_t seed = rng_derive_seed(job->seed, index);
+    worker->stats.games++;
+    bool small = !job->no_guess && bitboard_fits(job->difficulty->width, job->difficulty->height);
+    if (small && sim_play_bitboard(worker, seed)) {
+        return;
+    }
+    game_init(game, job->difficulty->width, job->difficulty->height, job->difficulty->mines, seed, 0);
+    if (small) {
+        // already populated and clicked, only the solver starts over
+        bitboard_store(&worker->board, &game->minefield);
+    } else {
+        if (job->no_guess) {
+            noguess_populate(&game->minefield, 1); // this thread is already one of many
+        } else {
+            minefield_populate(&game->minefield);
+        }
+        size_t bv3 = minefield_3bv(&game->minefield);
+        if (bv3 != SIZE_MAX) {
+            worker->stats.bv += bv3;
+            worker->stats.bv_games++;
+        }
+        worker->stats.openings += game->minefield.openings.count;
+        game_click_tile(game, game->minefield.cur.x, game->minefield.cur.y);
+    }
+    game_autoplay(game, true);
+
+    worker->stats.guesses += game->guesses;
+    if (game->state == VICTORY) {
+        worker->stats.wins++;
+    }
+}
+
+static void *sim_worker_run(void *arg) {
+    struct SimWorker *worker = arg;
+    struct SimJob *job = worker->job;
+    for (;;) {
+        uint64_t start = __atomic_fetch_add(&job->next, BATCH, __ATOMIC_RELAXED);
+        if (start >= job->games) {
+            return NULL;
+        }
+        uint64_t end = start + BATCH < job->games ? start + BATCH : job->games;
+        for (uint64_t i = start; i < end; i++) {
+            sim_play(worker, i);
+        }
+    }
+}
+
+// returns false if no threads could be started
+static bool sim_run(struct SimJob *job, int threads, struct SimStats *total) {
+    struct SimWorker *workers = calloc(threads, sizeof(struct SimWorker));
+    pthread_t *ids = calloc(threads, sizeof(pthread_t));
+    if (!workers || !ids) {
+        free(workers);
+        free(ids);
+        return false;
+    }
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        workers[i].job = job;
+        // the threads already keep every CPU busy
+        workers[i].game.probability.threads = 1;
+        // gives the 3BV and openings without another pass, and first clicks are usually on an opening
+        workers[i].game.minefield.index_openings = true;
+        if (pthread_create(&ids[started], NULL, sim_worker_run, &workers[i]) == 0) {
+            started++;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    *total = (struct SimStats){0};
+    for (int i = 0; i < threads; i++) {
+        total->games += workers[i].stats.games;
+        total->wins += workers[i].stats.wins;
+        total->guesses += workers[i].stats.guesses;
+        total->bv += workers[i].stats.bv;
+        total->bv_games += workers[i].stats.bv_games;
+        total->openings += workers[i].stats.openings;
+        game_cleanup(&workers[i].game);
+    }
+    free(workers);
+    free(ids);
+    return started > 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const char cmd_usage[] =
+        "Usage: smines-sim [options]\n"
+    ;
+    static const char cmd_help[] =
+        "Options:\n"
+        "  -h, --help\n"
+        "  -d, --difficulty=DIFFICULTY      Difficulty to play, can be given more than once (default: all of them)\n"
+        "  -n, --games=GAMES                Games per difficulty (default 100000)\n"
+        "  -t, --threads=THREADS            Threads to play on (default: one per CPU)\n"
+        "  -s, --seed=SEED                  Seed the games are derived from (default: the same every run)\n"
+        "  -g, --no-guess                   Deal boards like smines --no-guess\n"
+        "Output columns:\n"
+        "  win_rate             games won / games played\n"
+        "  guesses_per_game     moves made without knowing they were safe\n"
+        "  avg_3bv              clicks needed to clear the board without flags, averaged over every board\n"
+        "  avg_openings         areas of zeroes (that reveal everything around them), averaged over every board\n"
+    ;
+
+    static int help_flag = 0;
+    static int no_guess_flag = 0;
+    static const struct option long_options[] = {
+        { "help",       no_argument,        &help_flag,     1   },
+        { "difficulty", required_argument,  0,              'd' },
+        { "games",      required_argument,  0,              'n' },
+        { "threads",    required_argument,  0,              't' },
+        { "seed",       required_argument,  0,              's' },
+        { "no-guess",   no_argument,        &no_guess_flag, 1   },
+        { 0, 0, 0, 0 }
+    };
+    const struct Difficulty *chosen[16];
+    size_t chosen_len = 0;
+    uint64_t games = DEFAULT_GAMES;
+    uint64_t seed = DEFAULT_SEED;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus < 1 ? 1 : cpus > MAX_THREADS ? MAX_THREADS : cpus;
+
+    bool exit_for_invalid_args = false;
+    int opt_idx = 0;
+    char *strtol_endptr;
+    int c;
+    while ((c = getopt_long(argc, argv, "hd:n:t:s:g", long_options, &opt_idx)) != -1) {
+        switch (c) {
+            case 0:
+                // do nothing else if flag was set
+                if (long_options[opt_idx].flag != 0) {
+                    break;
+                }
+                abort();
+            case '?':
+                exit_for_invalid_args = true;
+                break;
+            case 'h':
+                help_flag = 1;
+                break;
+            case 'd': {
+                const struct Difficulty *difficulty = difficulty_find(optarg);
+                if (!difficulty) {
+                    printf("invalid difficulty: %s\n", optarg);
+                    exit_for_invalid_args = true;
+                } else if (chosen_len < sizeof(chosen) / sizeof(chosen[0])) {
+                    chosen[chosen_len++] = difficulty;
+                }
+                break;
+            }
+            case 'n':
+                errno = 0;
+                games = strtoull(optarg, &strtol_endptr, 10);
+                if (optarg == strtol_endptr || *strtol_endptr != '\0' || errno != 0 || games == 0) {
+                    printf("error parsing 'games' as a positive number\n");
+                    exit_for_invalid_args = true;
+                }
+                break;
+            case 't':
+                errno = 0;
+                threads = strtol(optarg, &strtol_endptr, 10);
+                if (optarg == strtol_endptr || *strtol_endptr != '\0' || errno != 0 || threads < 1 || threads > MAX_THREADS) {
+                    printf("'threads' must be a number from 1 to %d\n", MAX_THREADS);
+                    exit_for_invalid_args = true;
+                }
+                break;
+            case 's':
+                errno = 0;
+                seed = strtoull(optarg, &strtol_endptr, 10);
+                if (optarg == strtol_endptr || *strtol_endptr != '\0' || errno != 0) {
+                    printf("error parsing 'seed' as number\n");
+                    exit_for_invalid_args = true;
+                }
+                break;
+            case 'g':
+                no_guess_flag = 1;
+                break;
+            default:
+                abort();
+        }
+    }
+    if (help_flag) {
+        printf(cmd_usage);
+        printf(cmd_help);
+        return 0;
+    }
+    if (exit_for_invalid_args) {
+        printf(cmd_usage);
+        printf("Use the '--help' option to display help page\n");
+        return 1;
+    }
+    if (chosen_len == 0) {
+        for (size_t i = 0; i < difficulties_len && i < sizeof(chosen) / sizeof(chosen[0]); i++) {
+            chosen[chosen_len++] = &difficulties[i];
+        }
+    }
+
+    printf("difficulty,width,height,mines,seed,no_guess,games,wins,win_rate,guesses_per_game,avg_3bv,avg_openings,seconds,games_per_sec\n");
+    for (size_t i = 0; i < chosen_len; i++) {
+        struct SimJob job = {
+            .difficulty = chosen[i],
+            .seed = seed,
+            .games = games,
+            .no_guess = no_guess_flag,
+            .next = 0,
+        };
+        struct SimStats stats;
+        double start = now();
+        if (!sim_run(&job, threads, &stats)) {
+            fprintf(stderr, "couldn't start any threads\n");
+            return 1;
+        }
+        double seconds = now() - start;
+        printf("%s,%zu,%zu,%zu,%" PRIu64 ",%d,%" PRIu64 ",%" PRIu64 ",%.4f,%.3f,%.2f,%.2f,%.3f,%.0f\n",
+                chosen[i]->name, chosen[i]->width, chosen[i]->height, chosen[i]->mines, seed, no_guess_flag,
+                stats.games, stats.wins, (double)stats.wins / stats.games, (double)stats.guesses / stats.games,
+                stats.bv_games ? (double)stats.bv / stats.bv_games : 0, (double)stats.openings / stats.games, seconds, stats.games / seconds);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include "solver.h"
+
+#include "minefield.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool solver_list_grow(struct SolverList *list, size_t limit) {
+    if (list->len < list->cap) {
+        return true;
+    }
+    size_t cap = list->cap ? list->cap * 2 : 64;
+    if (limit && cap > limit) {
+        cap = limit;
+    }
+    size_t *items = cap > list->cap ? realloc(list->items, cap * sizeof(size_t)) : NULL;
+    if (!items) {
+        return false;
+    }
+    list->items = items;
+    list->cap = cap;
+    return true;
+}
+// if the list can't grow, the solver goes stale instead: the next solver_solve starts over from the
+// whole board, which only needs the tiles
+static void solver_list_push(struct Solver *solver, struct SolverList *list, size_t offset) {
+    if (!solver_list_grow(list, 0)) {
+        solver->stale = true;
+        return;
+    }
+    list->items[list->len++] = offset;
+}
+static void solver_list_free(struct SolverList *list) {
+    free(list->items);
+    *list = (struct SolverList){0};
+}
+
+// everything solver_init does except the tiles
+static void solver_reset_lists(struct Solver *solver, struct Minefield *minefield) {
+    solver->minefield = minefield;
+    solver->revealed.len = 0;
+    solver->queue.len = 0;
+    solver->subset_queue.len = 0;
+    solver->safe.len = 0;
+    solver->mines.len = 0;
+    solver->stale = false;
+    solver->revision++;
+}
+
+bool solver_init(struct Solver *solver, struct Minefield *minefield) {
+    solver_reset_lists(solver, minefield);
+    size_t tiles_len = minefield->width * minefield->height;
+    if (solver->tiles && solver->tiles_len == tiles_len) {
+        memset(solver->tiles, 0, tiles_len);
+        return true;
+    }
+    free(solver->tiles);
+    solver->tiles = calloc(tiles_len, sizeof(uint8_t));
+    solver->tiles_len = solver->tiles ? tiles_len : 0;
+    if (!solver->tiles) {
+        return false;
+    }
+    return true;
+}
+
+uint8_t *solver_init_with_tiles(struct Solver *solver, struct Minefield *minefield, uint8_t *tiles) {
+    solver_reset_lists(solver, minefield);
+    uint8_t *old = solver->tiles;
+    solver->tiles = tiles;
+    solver->tiles_len = tiles ? minefield->width * minefield->height : 0;
+    return old;
+}
+
+void solver_cleanup(struct Solver *solver) {
+    free(solver->tiles);
+    solver->tiles = NULL;
+    solver->tiles_len = 0;
+    solver_list_free(&solver->revealed);
+    solver_list_free(&solver->queue);
+    solver_list_free(&solver->subset_queue);
+    solver_list_free(&solver->safe);
+    solver_list_free(&solver->mines);
+}
+
+void solver_tile_revealed(struct Solver *solver, size_t offset) {
+    solver->revision++;
+    if (solver->stale) {
+        return;
+    }
+    // past this many, rescanning the board is about as cheap as going through the list
+    size_t limit = solver->minefield->width * solver->minefield->height / 4 + 64;
+    if (!solver_list_grow(&solver->revealed, limit)) {
+        solver->stale = true;
+        return;
+    }
+    solver->revealed.items[solver->revealed.len++] = offset;
+}
+
+void solver_reset(struct Solver *solver) {
+    solver->revision++;
+    solver->stale = true;
+}
+
+// the tiles within `radius` of (x, y), clipped to the edges of the board
+struct SolverArea {
+    size_t x_start, y_start;
+    size_t x_end, y_end; // inclusive
+};
+static struct SolverArea solver_area(struct Minefield *minefield, size_t x, size_t y, size_t radius) {
+    struct SolverArea area;
+    area.x_start = x > radius ? x - radius : 0;
+    area.y_start = y > radius ? y - radius : 0;
+    area.x_end = x + radius < minefield->width ? x + radius : minefield->width - 1;
+    area.y_end = y + radius < minefield->height ? y + radius : minefield->height - 1;
+    return area;
+}
+
+// visible numbers are the only tiles that tell us anything
+static bool solver_is_number(struct Tile *tile) {
+    return tile_is_visible(tile) && !tile_is_mine(tile) && tile_surrounding(tile) != 0;
+}
+
+// put a tile back in line for both kinds of deductions, if it's a number
+static void solver_queue(struct Solver *solver, size_t offset) {
+    struct Minefield *minefield = solver->minefield;
+    if (!solver_is_number(minefield_get_tile(minefield, offset % minefield->width, offset / minefield->width))) {
+        return;
+    }
+    if (!(solver->tiles[offset] & SOLVER_QUEUED)) {
+        solver->tiles[offset] |= SOLVER_QUEUED;
+        solver_list_push(solver, &solver->queue, offset);
+    }
+    if (!(solver->tiles[offset] & SOLVER_SUBSET_QUEUED)) {
+        solver->tiles[offset] |= SOLVER_SUBSET_QUEUED;
+        solver_list_push(solver, &solver->subset_queue, offset);
+    }
+}
+// the numbers around a tile have to be looked at again when something about it changes
+static void solver_queue_around(struct Solver *solver, size_t offset) {
+    struct Minefield *minefield = solver->minefield;
+    struct SolverArea area = solver_area(minefield, offset % minefield->width, offset / minefield->width, 1);
+    for (size_t y = area.y_start; y <= area.y_end; y++) {
+        for (size_t x = area.x_start; x <= area.x_end; x++) {
+            solver_queue(solver, y * minefield->width + x);
+        }
+    }
+}
+
+static void solver_mark(struct Solver *solver, size_t offset, uint8_t bit) {
+    solver->tiles[offset] |= bit;
+    solver_list_push(solver, bit == SOLVER_SAFE ? &solver->safe : &solver->mines, offset);
+    solver_queue_around(solver, offset);
+}
+
+// hidden neighbors of a number that aren't known to be safe or mines yet, returns how many
+// *mines_left is how many of them are mines
+static size_t solver_unknown_neighbors(struct Solver *solver, size_t offset, size_t unknown[8], size_t *mines_left) {
+    struct Minefield *minefield = solver->minefield;
+    size_t x = offset % minefield->width;
+    size_t y = offset / minefield->width;
+    size_t len = 0;
+    size_t known_mines = 0;
+    struct SolverArea area = solver_area(minefield, x, y, 1);
+    for (size_t y1 = area.y_start; y1 <= area.y_end; y1++) {
+        for (size_t x1 = area.x_start; x1 <= area.x_end; x1++) {
+            size_t offset1 = y1 * minefield->width + x1;
+            if (tile_is_visible(minefield_get_tile(minefield, x1, y1))) {
+                continue;
+            }
+            if (solver->tiles[offset1] & SOLVER_MINE) {
+                known_mines++;
+            } else if (!(solver->tiles[offset1] & SOLVER_SAFE)) {
+                unknown[len++] = offset1;
+            }
+        }
+    }
+    *mines_left = tile_surrounding(minefield_get_tile(minefield, x, y)) - known_mines;
+    return len;
+}
+
+// single point deductions for one number, returns how many tiles were found
+static size_t solver_examine(struct Solver *solver, size_t offset) {
+    size_t unknown[8];
+    size_t mines_left;
+    size_t len = solver_unknown_neighbors(solver, offset, unknown, &mines_left);
+    if (len == 0) {
+        return 0;
+    }
+    uint8_t bit;
+    if (mines_left == 0) {
+        bit = SOLVER_SAFE;
+    } else if (mines_left == len) {
+        bit = SOLVER_MINE;
+    } else {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        solver_mark(solver, unknown[i], bit);
+    }
+    return len;
+}
+
+static bool solver_list_contains(const size_t *items, size_t len, size_t offset) {
+    for (size_t i = 0; i < len; i++) {
+        if (items[i] == offset) {
+            return true;
+        }
+    }
+    return false;
+}
+// if `small` is a proper subset of `big`, the tiles only in `big` hold big_left - small_left mines
+// returns how many tiles were found
+static size_t solver_try_subset(struct Solver *solver, const size_t *small, size_t small_len, size_t small_left,
+                                const size_t *big, size_t big_len, size_t big_left) {
+    if (small_len >= big_len || small_left > big_left) {
+        return 0;
+    }
+    for (size_t i = 0; i < small_len; i++) {
+        if (!solver_list_contains(big, big_len, small[i])) {
+            return 0;
+        }
+    }
+    size_t rest = big_len - small_len;
+    uint8_t bit;
+    if (big_left == small_left) {
+        bit = SOLVER_SAFE;
+    } else if (big_left - small_left == rest) {
+        bit = SOLVER_MINE;
+    } else {
+        return 0;
+    }
+    for (size_t i = 0; i < big_len; i++) {
+        if (!solver_list_contains(small, small_len, big[i])) {
+            solver_mark(solver, big[i], bit);
+        }
+    }
+    return rest;
+}
+// subset deductions between one number and every number that shares unknown neighbors with it
+// (which are all within 2 tiles), returns how many tiles were found
+static size_t solver_examine_subsets(struct Solver *solver, size_t offset) {
+    struct Minefield *minefield = solver->minefield;
+    size_t unknown[8];
+    size_t mines_left;
+    size_t len = solver_unknown_neighbors(solver, offset, unknown, &mines_left);
+    if (len == 0) {
+        return 0;
+    }
+    struct SolverArea area = solver_area(minefield, offset % minefield->width, offset / minefield->width, 2);
+    for (size_t y = area.y_start; y <= area.y_end; y++) {
+        for (size_t x = area.x_start; x <= area.x_end; x++) {
+            size_t other = y * minefield->width + x;
+            if (other == offset || !solver_is_number(minefield_get_tile(minefield, x, y))) {
+                continue;
+            }
+            size_t other_unknown[8];
+            size_t other_left;
+            size_t other_len = solver_unknown_neighbors(solver, other, other_unknown, &other_left);
+            size_t found = solver_try_subset(solver, unknown, len, mines_left, other_unknown, other_len, other_left);
+            if (!found) {
+                found = solver_try_subset(solver, other_unknown, other_len, other_left, unknown, len, mines_left);
+            }
+            if (found) {
+                // the other pairs have to be checked again with what was just found
+                solver_queue(solver, offset);
+                return found;
+            }
+        }
+    }
+    return 0;
+}
+
+// start over from the whole board, keeping what was already found
+static void solver_rescan(struct Solver *solver) {
+    struct Minefield *minefield = solver->minefield;
+    solver->queue.len = 0;
+    solver->subset_queue.len = 0;
+    solver->safe.len = 0;
+    solver->mines.len = 0;
+    solver->stale = false;
+    for (size_t y = 0; y < minefield->height; y++) {
+        for (size_t x = 0; x < minefield->width; x++) {
+            size_t offset = y * minefield->width + x;
+            solver->tiles[offset] &= SOLVER_SAFE | SOLVER_MINE;
+            if (solver->tiles[offset] & SOLVER_MINE) {
+                solver_list_push(solver, &solver->mines, offset);
+            } else if ((solver->tiles[offset] & SOLVER_SAFE) && !tile_is_visible(minefield_get_tile(minefield, x, y))) {
+                solver_list_push(solver, &solver->safe, offset);
+            }
+            solver_queue(solver, offset);
+        }
+    }
+}
+
+size_t solver_solve(struct Solver *solver) {
+    if (solver->stale) {
+        solver_rescan(solver);
+    } else {
+        for (size_t i = 0; i < solver->revealed.len; i++) {
+            solver_queue_around(solver, solver->revealed.items[i]);
+        }
+    }
+    solver->revealed.len = 0;
+
+    // single point deductions are cheaper, so only fall back to subsets when they run dry
+    size_t found = 0;
+    // stale again means out of memory, what was found so far is still right but the queues aren't complete
+    while (!solver->stale) {
+        if (solver->queue.len > 0) {
+            size_t offset = solver->queue.items[--solver->queue.len];
+            solver->tiles[offset] &= ~SOLVER_QUEUED;
+            found += solver_examine(solver, offset);
+        } else if (solver->subset_queue.len > 0) {
+            size_t offset = solver->subset_queue.items[--solver->subset_queue.len];
+            solver->tiles[offset] &= ~SOLVER_SUBSET_QUEUED;
+            found += solver_examine_subsets(solver, offset);
+        } else {
+            break;
+        }
+    }
+    return found;
+}
+
+bool solver_next_safe(struct Solver *solver, size_t x, size_t y, size_t *safe_x, size_t *safe_y) {
+    struct Minefield *minefield = solver->minefield;
+    bool found = false;
+    size_t best_distance = SIZE_MAX;
+    for (size_t i = 0; i < solver->safe.len;) {
+        size_t offset = solver->safe.items[i];
+        size_t x1 = offset % minefield->width;
+        size_t y1 = offset / minefield->width;
+        if (tile_is_visible(minefield_get_tile(minefield, x1, y1))) {
+            // already revealed, it's not coming back (short of undo, which rescans anyway)
+            solver->safe.items[i] = solver->safe.items[--solver->safe.len];
+            continue;
+        }
+        size_t dx = x1 > x ? x1 - x : x - x1;
+        size_t dy = y1 > y ? y1 - y : y - y1;
+        size_t distance = dx > dy ? dx : dy;
+        if (distance < best_distance) {
+            best_distance = distance;
+            *safe_x = x1;
+            *safe_y = y1;
+            found = true;
+        }
+        i++;
+    }
+    return found;
+}